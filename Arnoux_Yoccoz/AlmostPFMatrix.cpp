@@ -9,7 +9,8 @@
 #include "AlmostPFMatrix.h"
 
 
-AlmostPFMatrix::AlmostPFMatrix(const std::vector<std::vector<int>>& Matrix):
+template <typename Precision>
+AlmostPFMatrix<Precision>::AlmostPFMatrix(const std::vector<std::vector<int>>& Matrix):
     m_data(Matrix)
 {
     assert(Matrix.size() == Matrix[0].size()); // making sure it is a square matrix
@@ -24,7 +25,8 @@ AlmostPFMatrix::AlmostPFMatrix(const std::vector<std::vector<int>>& Matrix):
 
 
 
-void AlmostPFMatrix::InitEigenData(){
+template <typename Precision>
+void AlmostPFMatrix<Precision>::InitEigenData(){
     if (IsPerronFrobenius_Init()) {
         m_PFEigenvector.resize(Size());
         Eigen::MatrixXd EigenMatrix(Size(), Size());
@@ -49,12 +51,77 @@ void AlmostPFMatrix::InitEigenData(){
         for(int i = 0; i < Size(); i++){
             m_PFEigenvector[i] = fabs(real(es.eigenvectors().col(IndexOfLargest)[i]));
         }
+        RefineEigenData();
     }
 }
 
 
 
 
+// Inverse iteration with the shift m_PFEigenvalue, which is accurate to double precision. Since the shift is so close to the
+// eigenvalue, every iteration gains about as many digits as double has, so a few iterations are enough for any of our
+// precisions. The linear systems are solved by Gaussian elimination with partial pivoting in floating_point_type.
+// Finally the eigenvalue is recomputed from the refined eigenvector.
+template <typename Precision>
+void AlmostPFMatrix<Precision>::RefineEigenData(){
+    const int NUM_ITERATIONS = 4;
+    
+    std::vector<floating_point_type>& x = m_PFEigenvector;
+    for (int Iteration = 0; Iteration < NUM_ITERATIONS; Iteration++) {
+        // Setting up the system (Matrix - Shift * Id) y = x
+        std::vector<std::vector<floating_point_type>> System(Size(), std::vector<floating_point_type>(Size() + 1));
+        for (int i = 0; i < Size(); i++) {
+            for (int j = 0; j < Size(); j++) {
+                System[i][j] = floating_point_type(m_data[i][j]);
+            }
+            System[i][i] -= m_PFEigenvalue;
+            System[i][Size()] = x[i];
+        }
+        
+        for (int Column = 0; Column < Size(); Column++) {
+            int PivotRow = Column;
+            for (int i = Column + 1; i < Size(); i++) {
+                if (Abs(System[i][Column]) > Abs(System[PivotRow][Column])) {
+                    PivotRow = i;
+                }
+            }
+            if (System[PivotRow][Column] == 0) {
+                return;     // the shift is an exact eigenvalue, so x can't be improved
+            }
+            std::swap(System[Column], System[PivotRow]);
+            for (int i = Column + 1; i < Size(); i++) {
+                floating_point_type Factor = System[i][Column] / System[Column][Column];
+                for (int j = Column; j <= Size(); j++) {
+                    System[i][j] -= Factor * System[Column][j];
+                }
+            }
+        }
+        
+        floating_point_type Sum = 0;
+        for (int i = Size() - 1; i >= 0; i--) {
+            floating_point_type Value = System[i][Size()];
+            for (int j = i + 1; j < Size(); j++) {
+                Value -= System[i][j] * x[j];
+            }
+            x[i] = Value / System[i][i];
+            Sum += x[i];
+        }
+        for (int i = 0; i < Size(); i++) {
+            x[i] /= Sum;    // the eigenvector is positive, so normalizing by the sum fixes the sign, too
+        }
+    }
+    
+    // Since the sum of the entries of x is 1, the eigenvalue is the sum of the entries of Matrix * x
+    floating_point_type Eigenvalue = 0;
+    for (int i = 0; i < Size(); i++) {
+        for (int j = 0; j < Size(); j++) {
+            Eigenvalue += floating_point_type(m_data[i][j]) * x[j];
+        }
+    }
+    m_PFEigenvalue = Eigenvalue;
+}
+
+
 
 
 
@@ -62,7 +129,10 @@ void AlmostPFMatrix::InitEigenData(){
 
 
 
-void AlmostPFMatrix::Transpose(){
+
+
+template <typename Precision>
+void AlmostPFMatrix<Precision>::Transpose(){
     std::vector<std::vector<int>> Copy(m_data);
     
     for (int i = 0; i < Size(); i++) {
@@ -75,7 +145,8 @@ void AlmostPFMatrix::Transpose(){
 
 
 
-bool AlmostPFMatrix::IsEveryVertexReachableFrom(int Vertex) const{
+template <typename Precision>
+bool AlmostPFMatrix<Precision>::IsEveryVertexReachableFrom(int Vertex) const{
     int CountReachableVertices = 1;
     
     enum vertex_status{
@@ -108,7 +179,8 @@ bool AlmostPFMatrix::IsEveryVertexReachableFrom(int Vertex) const{
 }
 
 
-bool AlmostPFMatrix::IsReachableFromEveryVertex(int Vertex) {
+template <typename Precision>
+bool AlmostPFMatrix<Precision>::IsReachableFromEveryVertex(int Vertex) {
     Transpose();
     bool temp = IsEveryVertexReachableFrom(Vertex);
     Transpose();
@@ -118,7 +190,8 @@ bool AlmostPFMatrix::IsReachableFromEveryVertex(int Vertex) {
 
 
 
-std::ostream& operator<<(std::ostream& Out, const AlmostPFMatrix& Matrix){
+template <typename Precision>
+std::ostream& operator<<(std::ostream& Out, const AlmostPFMatrix<Precision>& Matrix){
     for (int i = 0; i < Matrix.Size(); i++) {
         for (int j = 0; j < Matrix.Size(); j++) {
             Out << Matrix.m_data[i][j] << " ";
@@ -134,17 +207,9 @@ std::ostream& operator<<(std::ostream& Out, const AlmostPFMatrix& Matrix){
 
 
 
-AlmostPFMatrix ArnouxYoccozMatrix(int genus){
-    std::vector<std::vector<int>> Matrix(genus, std::vector<int>(genus));
-    
-    Matrix[0][0] = 1;
-    Matrix[0][genus - 1] = 1;
-    for (int i = 1; i < genus - 1; i++) {
-        Matrix[i][i - 1] = 1;
-    }
-    for (int i = 0; i < genus - 1; i++) {
-        Matrix[genus - 1][i] = 1;
-    }
-    return AlmostPFMatrix(Matrix);
-}
+#define INSTANTIATE_ALMOST_PF_MATRIX(Precision) \
+    template class AlmostPFMatrix<Precision>; \
+    template std::ostream& operator<<(std::ostream&, const AlmostPFMatrix<Precision>&);
+
+FOR_EACH_PRECISION(INSTANTIATE_ALMOST_PF_MATRIX)
 
@@ -15,8 +15,13 @@
 #include "Eigen/Eigenvalues"
 #include "CirclePoint.h"
 
+// The Perron-Frobenius eigenvalue and eigenvector are first computed by Eigen in double precision, then refined
+// by inverse iteration in the real type of the Precision policy, so they are accurate in any precision.
+template <typename Precision = DefaultPrecision>
 class AlmostPFMatrix{
 public:
+    typedef typename Precision::real_type floating_point_type;
+
     AlmostPFMatrix(const std::vector<std::vector<int>>& Matrix);
     // AlmostPFMatrix(int Size) : m_data(Size, std::vector<int>(Size, 0)), m_PFEigenvector(0), m_PFEigenvalue(0) {}
    // void SetEntry(int i, int j, int Value) { m_data[i][j] = Value; }
@@ -26,7 +31,7 @@ public:
     std::vector<floating_point_type> GetPFEigenvector() const { return m_PFEigenvector; }
     floating_point_type GetPFEigenvalue() const { return m_PFEigenvalue; }
     
-    friend std::ostream& operator<<(std::ostream& Out, const AlmostPFMatrix& Matrix);
+    template <typename P> friend std::ostream& operator<<(std::ostream& Out, const AlmostPFMatrix<P>& Matrix);
     
 private:
     std::vector<std::vector<int>> m_data;
@@ -35,12 +40,47 @@ private:
     
     void Transpose();
     void InitEigenData();
+    void RefineEigenData();
     bool IsPerronFrobenius_Init() {return IsEveryVertexReachableFrom(0) && IsReachableFromEveryVertex(0); }
     bool IsReachableFromEveryVertex(int Vertex);
     bool IsEveryVertexReachableFrom(int Vertex) const;
 };
 
-AlmostPFMatrix ArnouxYoccozMatrix(int genus);
+
+template <typename Precision = DefaultPrecision>
+AlmostPFMatrix<Precision> ArnouxYoccozMatrix(int genus){
+    std::vector<std::vector<int>> Matrix(genus, std::vector<int>(genus));
+    
+    Matrix[0][0] = 1;
+    Matrix[0][genus - 1] = 1;
+    for (int i = 1; i < genus - 1; i++) {
+        Matrix[i][i - 1] = 1;
+    }
+    for (int i = 0; i < genus - 1; i++) {
+        Matrix[genus - 1][i] = 1;
+    }
+    return AlmostPFMatrix<Precision>(Matrix);
+}
+
+
+// The lengths of the Arnoux-Yoccoz foliation of the genus, computed in the Precision. The Intervals 2i and 2i + 1 are
+// paired, as in the WeighedTree with a single vertex of degree genus. The powers of ALPHA are multiplied out, since
+// not every real type has pow.
+template <typename Precision = DefaultPrecision>
+std::vector<typename Precision::real_type> ArnouxYoccozLengths(int genus){
+    typedef typename Precision::real_type floating_point_type;
+    floating_point_type alpha = 1/ArnouxYoccozMatrix<Precision>(genus).GetPFEigenvalue();
+    std::vector<floating_point_type> Powers(genus + 2, floating_point_type(1));
+    for (int i = 1; i < genus + 2; i++) {
+        Powers[i] = Powers[i - 1] * alpha;
+    }
+    std::vector<floating_point_type> Lengths(2 * genus);
+    for (int i = 1; i < genus; i++) {
+        Lengths[2 * i - 2] = Lengths[2 * i - 1] = (Powers[i] + Powers[i + 1])/4;
+    }
+    Lengths[2 * genus - 2] = Lengths[2 * genus - 1] = (alpha + Powers[genus])/4;
+    return Lengths;
+}
 
 
 #endif /* defined(__Arnoux_Yoccoz__AlmostPFMatrix__) */
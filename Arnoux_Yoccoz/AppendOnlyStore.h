@@ -0,0 +1,81 @@
+/*******************************************************************************
+ *  CLASS NAME:	AppendOnlyStore
+ *  AUTHOR:		Balazs Strenner
+ *				Copyright 2013 UW-Madison. All rights reserved.
+ *
+ *	DESCRIPTION: A sequence that grows only at its end, and whose entries never move.
+
+    STORAGE:    The entries are stored in blocks of APPEND_ONLY_STORE_BLOCK_SIZE entries, one after the other. A block is
+                allocated in one piece when the previous one is full and is never reallocated, so references to the
+                entries stay valid while more entries are appended, and the entries are looked up by index as in an
+                array. Entries can only be removed from the end, or all at once (Clear).
+
+    USE:        The good shifted separatrix segments of a separatrix are appended in the order of their depth, and
+                FoliationRP2 keeps references to them while looking for more. Since the depths are increasing, a depth
+                is found by binary search.
+ *
+ *
+ ******************************************************************************/
+
+#ifndef ArnouxYoccoz_AppendOnlyStore_h
+#define ArnouxYoccoz_AppendOnlyStore_h
+
+#include <vector>
+
+
+
+const int APPEND_ONLY_STORE_LOG_BLOCK_SIZE = 6;
+const int APPEND_ONLY_STORE_BLOCK_SIZE = 1 << APPEND_ONLY_STORE_LOG_BLOCK_SIZE;
+
+
+
+template <typename T>
+class AppendOnlyStore{
+public:
+    AppendOnlyStore() : m_Size(0) {}
+    AppendOnlyStore(const AppendOnlyStore& Store) : m_Size(0) { Append(Store); }
+    AppendOnlyStore& operator=(const AppendOnlyStore& Store){
+        if (this != &Store) {
+            Clear();
+            Append(Store);
+        }
+        return *this;
+    }
+
+    int Size() const{ return m_Size; }
+    bool IsEmpty() const{ return m_Size == 0; }
+    T& operator[](int Index){ return m_Blocks[Index >> APPEND_ONLY_STORE_LOG_BLOCK_SIZE][Index & (APPEND_ONLY_STORE_BLOCK_SIZE - 1)]; }
+    const T& operator[](int Index) const{ return m_Blocks[Index >> APPEND_ONLY_STORE_LOG_BLOCK_SIZE][Index & (APPEND_ONLY_STORE_BLOCK_SIZE - 1)]; }
+    T& Back(){ return (*this)[m_Size - 1]; }
+
+    void PushBack(const T& Entry){
+        if ((m_Size & (APPEND_ONLY_STORE_BLOCK_SIZE - 1)) == 0 && m_Size >> APPEND_ONLY_STORE_LOG_BLOCK_SIZE == m_Blocks.size()) {
+            m_Blocks.push_back(std::vector<T>());
+            m_Blocks.back().reserve(APPEND_ONLY_STORE_BLOCK_SIZE);  // moving the blocks around keeps this storage
+        }
+        m_Blocks[m_Size >> APPEND_ONLY_STORE_LOG_BLOCK_SIZE].push_back(Entry);
+        m_Size++;
+    }
+    void PopBack(){
+        m_Size--;
+        m_Blocks[m_Size >> APPEND_ONLY_STORE_LOG_BLOCK_SIZE].pop_back();   // the empty block is kept for the next entry
+    }
+    void Clear(){
+        m_Blocks.clear();
+        m_Size = 0;
+    }
+
+private:
+    std::vector<std::vector<T>> m_Blocks;   // each reserved to APPEND_ONLY_STORE_BLOCK_SIZE
+    int m_Size;
+
+    void Append(const AppendOnlyStore& Store){
+        for (int i = 0; i < Store.m_Size; i++) {
+            PushBack(Store[i]);
+        }
+    }
+};
+
+
+
+#endif
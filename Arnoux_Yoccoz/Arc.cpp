@@ -10,7 +10,8 @@
 
 
 // sets values for the endpoints as inputs
-void Arc::Set(const CirclePoint& LeftEndpoint, const CirclePoint& RightEndpoint){        
+template <typename Precision>
+void Arc<Precision>::Set(const CirclePoint& LeftEndpoint, const CirclePoint& RightEndpoint){        
         // We assume that the length of the arc is less than 1. This is necessary because there are two arcs with LeftEndpoint = RightEndpoint, 
         // one with length 0, and one with length 1. So if the inputs are equal, we construct the arc of length 0.
         // Length 1 arcs therefore have to be constructed by giving length as one of the inputs.
@@ -23,14 +24,16 @@ void Arc::Set(const CirclePoint& LeftEndpoint, const CirclePoint& RightEndpoint)
 
 
 // decides whether t is in the arc
-bool Arc::ContainsQ(const CirclePoint& t) const{
+template <typename Precision>
+bool Arc<Precision>::ContainsQ(const CirclePoint& t) const{
     return m_Length == 1 ? true : IsBetween(m_LeftEndpoint, m_RightEndpoint, t);
 }
 
 
 
 // Cuts off a portion of the arc
-void Arc::CutOff(const CirclePoint& RefPoint, const CirclePoint& CuttingPoint){ 
+template <typename Precision>
+void Arc<Precision>::CutOff(const CirclePoint& RefPoint, const CirclePoint& CuttingPoint){ 
     
     // Divides the arc into two at CuttingPoint, throws away the one that does not contain RefPoint,
     // and updates the arc to the one that contains RefPoint.
@@ -60,7 +63,8 @@ void Arc::CutOff(const CirclePoint& RefPoint, const CirclePoint& CuttingPoint){
 
 
 // Prints out the arc in interval form
-std::ostream& operator<< (std::ostream &Out, const Arc &MyArc){
+template <typename Precision>
+std::ostream& operator<< (std::ostream &Out, const Arc<Precision> &MyArc){
     Out << "[" << MyArc.m_LeftEndpoint << "," << MyArc.m_RightEndpoint << "]";
     return Out;
 }
@@ -68,3 +72,9 @@ std::ostream& operator<< (std::ostream &Out, const Arc &MyArc){
 
 
 
+
+#define INSTANTIATE_ARC(Precision) \
+    template class Arc<Precision>; \
+    template std::ostream& operator<<(std::ostream&, const Arc<Precision>&);
+
+FOR_EACH_PRECISION(INSTANTIATE_ARC)
@@ -34,8 +34,12 @@
 #include "CirclePoint.h"
 
 
+template <typename Precision = DefaultPrecision>
 class Arc {        
 public:
+    typedef typename Precision::real_type floating_point_type;
+    typedef ::CirclePoint<Precision> CirclePoint;
+
 // CONSTRUCTORS
     
     // constructor for the endpoints as inputs            
@@ -64,7 +68,7 @@ public:
     void CutOff(const CirclePoint& RefPoint, const CirclePoint& CuttingPoint); // cuts off a portion of the arc
 
 // OPERATORS
-    friend std::ostream& operator<< (std::ostream &Out, const Arc &MyArc); // prints out the arc in interval form
+    template <typename P> friend std::ostream& operator<< (std::ostream &Out, const Arc<P> &MyArc); // prints out the arc in interval form
     
     
 private:
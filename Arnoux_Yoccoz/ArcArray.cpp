@@ -0,0 +1,173 @@
+/*******************************************************************************
+ *  CLASS NAME:	ArcArray
+ *  AUTHOR:		Balazs Strenner
+ *				Copyright 2013 UW-Madison. All rights reserved.
+ *
+ ******************************************************************************/
+
+
+#include "ArcArray.h"
+#include <cassert>
+
+
+
+
+template <typename Precision>
+ArcArray<Precision>::ArcArray(const std::vector<CirclePoint>& RefPoints, const CirclePoint& Endpoint) :
+    m_LeftCoordinates(RefPoints.size(), Endpoint.GetCoordinate()),
+    m_RightCoordinates(RefPoints.size(), Endpoint.GetCoordinate()),
+    m_RefCoordinates(RefPoints.size()),
+    m_Sides(RefPoints.size())
+{
+    for (int i = 0; i < Size(); i++) {
+        m_RefCoordinates[i] = RefPoints[i].GetCoordinate();
+        m_Sides[i] = static_cast<unsigned char>(ToSideBits(Endpoint) | ToSideBits(Endpoint) << 2 | ToSideBits(RefPoints[i]) << 4 | 1 << 6);
+    }
+}
+
+
+
+
+
+// An Arc made by Arc(Endpoint) is the whole circle. Its endpoints are the same and its length is 1, while an Arc
+// between two equal endpoints has length 0.
+template <typename Precision>
+ArcArray<Precision>::ArcArray(const std::vector<CirclePoint>& RefPoints, const std::vector<Arc>& Arcs) :
+    m_LeftCoordinates(RefPoints.size()),
+    m_RightCoordinates(RefPoints.size()),
+    m_RefCoordinates(RefPoints.size()),
+    m_Sides(RefPoints.size())
+{
+    for (int i = 0; i < Size(); i++) {
+        const CirclePoint& LeftEndpoint = Arcs[i].GetLeftEndpoint();
+        const CirclePoint& RightEndpoint = Arcs[i].GetRightEndpoint();
+        bool WholeCircle = LeftEndpoint == RightEndpoint && Arcs[i].GetLength() == 1;
+        m_LeftCoordinates[i] = LeftEndpoint.GetCoordinate();
+        m_RightCoordinates[i] = RightEndpoint.GetCoordinate();
+        m_RefCoordinates[i] = RefPoints[i].GetCoordinate();
+        m_Sides[i] = static_cast<unsigned char>(ToSideBits(LeftEndpoint) | ToSideBits(RightEndpoint) << 2 | ToSideBits(RefPoints[i]) << 4 |
+                                                WholeCircle << 6);
+    }
+}
+
+
+
+
+template <typename Precision>
+Arc<Precision> ArcArray<Precision>::GetArc(int Index) const{
+    CirclePoint LeftEndpoint = CirclePoint::FromReducedCoordinate(m_LeftCoordinates[Index], FromSideBits(m_Sides[Index] & 3));
+    if (m_Sides[Index] >> 6) {
+        return Arc(LeftEndpoint);
+    }
+    return Arc(LeftEndpoint, CirclePoint::FromReducedCoordinate(m_RightCoordinates[Index], FromSideBits((m_Sides[Index] >> 2) & 3)));
+}
+
+
+
+
+template <typename Precision>
+std::vector<Arc<Precision>> ArcArray<Precision>::GetArcs() const{
+    std::vector<Arc> Arcs;
+    Arcs.reserve(Size());
+    for (int i = 0; i < Size(); i++) {
+        Arcs.push_back(GetArc(i));
+    }
+    return Arcs;
+}
+
+
+
+
+// Every Arc is checked, without stopping at the first one containing c, so the loop has no branches.
+template <typename Precision>
+bool ArcArray<Precision>::ContainsQ(const CirclePoint& c) const{
+    const circle_coordinate_type& x = c.GetCoordinate();
+    const int Side = ToSideBits(c);
+    int Contains = 0;
+    for (int i = 0; i < Size(); i++) {
+        Contains |= (m_Sides[i] >> 6) | IsBetween(m_LeftCoordinates[i], m_Sides[i] & 3, m_RightCoordinates[i], (m_Sides[i] >> 2) & 3, x, Side);
+    }
+    return Contains != 0;
+}
+
+
+
+
+// The same as Arc::CutOff with the reference point of the Arc, but the Arc is left alone if it does not contain the
+// point. The new endpoints are selected by the masks Cut, CutLeft and CutRight instead of branches. (The side bits are
+// blended by bit operations, since the compiler would not select them without a branch.)
+template <typename Precision>
+inline void ArcArray<Precision>::CutOff(circle_coordinate_type& xLeft, circle_coordinate_type& xRight, const circle_coordinate_type& xRef,
+                                        unsigned char& Sides, const circle_coordinate_type& x, int Side){
+    const int LeftSide = Sides & 3;
+    const int RightSide = (Sides >> 2) & 3;
+    const int RefSide = (Sides >> 4) & 3;
+    const bool IsWholeCircle = (Sides >> 6) != 0;
+    const circle_coordinate_type OldLeft = xLeft;
+    const circle_coordinate_type OldRight = xRight;
+
+    const bool Cut = IsWholeCircle | IsBetween(OldLeft, LeftSide, OldRight, RightSide, x, Side);
+    const bool CutLeft = Cut & IsBetween(OldLeft, LeftSide, xRef, RefSide, x, Side);
+    const bool CutRight = Cut & !CutLeft;
+    Sides = static_cast<unsigned char>((LeftSide ^ ((LeftSide ^ Side) & -CutLeft)) | (RightSide ^ ((RightSide ^ Side) & -CutRight)) << 2 |
+                                       RefSide << 4 | (IsWholeCircle & !Cut) << 6);
+    xLeft = CutLeft ? x : OldLeft;
+    xRight = CutRight ? x : OldRight;
+}
+
+
+
+
+template <typename Precision>
+void ArcArray<Precision>::CutOff(const CirclePoint& CuttingPoint){
+    const circle_coordinate_type x = CuttingPoint.GetCoordinate();
+    const int Side = ToSideBits(CuttingPoint);
+    circle_coordinate_type* Left = m_LeftCoordinates.data();
+    circle_coordinate_type* Right = m_RightCoordinates.data();
+    const circle_coordinate_type* Ref = m_RefCoordinates.data();
+    unsigned char* Sides = m_Sides.data();
+    const int NumArcs = Size();
+    for (int i = 0; i < NumArcs; i++) {
+        CutOff(Left[i], Right[i], Ref[i], Sides[i], x, Side);
+    }
+}
+
+
+
+
+// Cuts the i'th Arc by the i'th cutting point, for each i. The side bits of the cutting points are taken from
+// CuttingSides shifted by SideShift. The arrays are __restrict, otherwise the compiler gives up checking them for
+// overlaps at run time and does not vectorize the loop.
+template <typename Precision>
+void ArcArray<Precision>::CutOff(int NumArcs, circle_coordinate_type* __restrict Left, circle_coordinate_type* __restrict Right,
+                                 const circle_coordinate_type* __restrict Ref, unsigned char* __restrict Sides,
+                                 const circle_coordinate_type* __restrict CuttingPoints, const unsigned char* __restrict CuttingSides,
+                                 int SideShift){
+    for (int i = 0; i < NumArcs; i++) {
+        CutOff(Left[i], Right[i], Ref[i], Sides[i], CuttingPoints[i], (CuttingSides[i] >> SideShift) & 3);
+    }
+}
+
+
+
+
+// The left endpoints are all done before the right endpoints, which is the same for each Arc as cutting by the left
+// endpoint first.
+template <typename Precision>
+void ArcArray<Precision>::CutOff(const ArcArray& CuttingArcs){
+    assert(&CuttingArcs != this);
+    CutOff(Size(), m_LeftCoordinates.data(), m_RightCoordinates.data(), m_RefCoordinates.data(), m_Sides.data(),
+           CuttingArcs.m_LeftCoordinates.data(), CuttingArcs.m_Sides.data(), 0);
+    CutOff(Size(), m_LeftCoordinates.data(), m_RightCoordinates.data(), m_RefCoordinates.data(), m_Sides.data(),
+           CuttingArcs.m_RightCoordinates.data(), CuttingArcs.m_Sides.data(), 2);
+}
+
+
+
+
+
+
+#define INSTANTIATE_ARC_ARRAY(Precision) \
+    template class ArcArray<Precision>;
+
+FOR_EACH_PRECISION(INSTANTIATE_ARC_ARRAY)
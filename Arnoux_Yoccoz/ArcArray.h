@@ -0,0 +1,74 @@
+/*******************************************************************************
+ *  CLASS NAME:	ArcArray
+ *  AUTHOR:		Balazs Strenner
+ *				Copyright 2013 UW-Madison. All rights reserved.
+ *
+ *	DESCRIPTION: Arcs around a set of reference points, one Arc around each, stored as a structure of arrays.
+
+    LAYOUT:     The coordinates of the left endpoints, the right endpoints and the reference points of the Arcs are in
+                three arrays, and the sides of the three points (see LeftOrRight) and whether the Arc is the whole
+                circle are packed into one byte for each Arc. The comparisons of CirclePoint are done on the coordinates
+                and the side bits without branches, so going through the Arcs reads the arrays in order and the
+                compiler can do several Arcs in one vector instruction.
+
+    USE:        ArcsAroundDivPoints keeps its Arcs here when its division points are not sorted. Then every Arc has to
+                be looked at when a point is inserted, and two ArcsAroundDivPoints are intersected Arc by Arc anyway.
+                The results are the same as with Arc::ContainsQ and Arc::CutOff, except that whole circle Arcs are
+                told by a flag and not by their length.
+ *
+ *
+ ******************************************************************************/
+
+#ifndef ArnouxYoccoz_ArcArray_h
+#define ArnouxYoccoz_ArcArray_h
+
+#include <vector>
+#include "Arc.h"
+
+
+
+template <typename Precision = DefaultPrecision>
+class ArcArray{
+public:
+    typedef typename Precision::coordinate_type circle_coordinate_type;
+    typedef ::CirclePoint<Precision> CirclePoint;
+    typedef ::Arc<Precision> Arc;
+
+    ArcArray() {}
+    ArcArray(const std::vector<CirclePoint>& RefPoints, const CirclePoint& Endpoint);  // whole circle Arcs starting and ending at Endpoint
+    ArcArray(const std::vector<CirclePoint>& RefPoints, const std::vector<Arc>& Arcs);  // the reverse of GetArcs
+
+    int Size() const{ return static_cast<int>(m_LeftCoordinates.size()); }
+    Arc GetArc(int Index) const;
+    std::vector<Arc> GetArcs() const;
+    bool ContainsQ(const CirclePoint& c) const;             // if any of the Arcs contains c
+    void CutOff(const CirclePoint& CuttingPoint);           // Arc::CutOff on every Arc containing CuttingPoint
+    void CutOff(const ArcArray& CuttingArcs);               // each Arc is cut by both endpoints of the Arc of the same index
+
+private:
+    std::vector<circle_coordinate_type> m_LeftCoordinates;
+    std::vector<circle_coordinate_type> m_RightCoordinates;
+    std::vector<circle_coordinate_type> m_RefCoordinates;
+    std::vector<unsigned char> m_Sides;     // the side of the left endpoint, the right endpoint and the reference point in 2 bits each, then the whole circle bit
+
+    static unsigned char ToSideBits(const CirclePoint& c){ return c.IsShiftedTo(LEFT) ? 0 : c.IsShiftedTo(CENTER) ? 1 : 2; }
+    static LeftOrRight FromSideBits(int Bits){ return Bits == 0 ? LEFT : Bits == 1 ? CENTER : RIGHT; }
+    static bool IsLess(const circle_coordinate_type& x1, int Side1, const circle_coordinate_type& x2, int Side2){
+        return (x1 < x2) | ((x1 == x2) & (Side1 < Side2));
+    }
+    static bool IsBetween(const circle_coordinate_type& xLeft, int SideLeft, const circle_coordinate_type& xRight, int SideRight,
+                          const circle_coordinate_type& x, int Side){
+        bool AfterLeft = !IsLess(x, Side, xLeft, SideLeft);
+        bool BeforeRight = !IsLess(xRight, SideRight, x, Side);
+        return (AfterLeft & BeforeRight) | (IsLess(xRight, SideRight, xLeft, SideLeft) & (AfterLeft | BeforeRight));
+    }
+    static void CutOff(circle_coordinate_type& xLeft, circle_coordinate_type& xRight, const circle_coordinate_type& xRef,
+                       unsigned char& Sides, const circle_coordinate_type& x, int Side);   // one Arc, the point given by its coordinate and side bits
+    static void CutOff(int NumArcs, circle_coordinate_type* __restrict Left, circle_coordinate_type* __restrict Right,
+                       const circle_coordinate_type* __restrict Ref, unsigned char* __restrict Sides,
+                       const circle_coordinate_type* __restrict CuttingPoints, const unsigned char* __restrict CuttingSides, int SideShift);
+};
+
+
+
+#endif
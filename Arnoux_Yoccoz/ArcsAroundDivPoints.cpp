@@ -9,34 +9,119 @@
 
 
 #include "ArcsAroundDivPoints.h"
+#include <algorithm>
+#include <cassert>
 
 
 
 
+// Assignment operator. Since m_DivPoints is not owned by the object, only the Arcs are copied.
+template <typename Precision>
+ArcsAroundDivPoints<Precision>& ArcsAroundDivPoints<Precision>::operator=(const ArcsAroundDivPoints& adp){
+    assert(&m_DivPoints == &adp.m_DivPoints);
+    m_Arcs = adp.m_Arcs;
+    m_ArcArray = adp.m_ArcArray;
+    return *this;
+}
+
+
+
+
+
+template <typename Precision>
+void ArcsAroundDivPoints<Precision>::SetArcs(const std::vector<Arc>& Arcs){
+    assert(Arcs.empty() || Arcs.size() == m_DivPoints.size());
+    if (m_AreDivPointsSorted) {
+        m_Arcs = SharedVector<Arc>(Arcs);
+    } else {
+        m_ArcArray = Arcs.empty() ? ArcArray() : ArcArray(m_DivPoints, Arcs);
+    }
+}
+
+
+
+
+template <typename Precision>
+bool ArcsAroundDivPoints<Precision>::AreSorted(const std::vector<CirclePoint>& DivPoints){
+    for (int i = 1; i < DivPoints.size(); i++) {
+        if (!IsCoordinateLess(DivPoints[i - 1], DivPoints[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+// The index of the last division point whose coordinate is not greater than that of c, or the last division point if
+// there is no such. So c is between this division point and the next one.
+template <typename Precision>
+int ArcsAroundDivPoints<Precision>::IndexBefore(const CirclePoint& c) const{
+    int Index = static_cast<int>(std::upper_bound(m_DivPoints.begin(), m_DivPoints.end(), c, IsCoordinateLess) - m_DivPoints.begin());
+    return Index > 0 ? Index - 1 : static_cast<int>(m_DivPoints.size()) - 1;
+}
+
+
 
 
 // Decides of a point if contained in any of the Arcs around the division points
-bool ArcsAroundDivPoints::ContainsQ(const CirclePoint& c) const{
+template <typename Precision>
+bool ArcsAroundDivPoints<Precision>::ContainsQ(const CirclePoint& c) const{
+    if (!IsEmpty() && m_AreDivPointsSorted) {
+        int Index = IndexBefore(c);
+        return m_Arcs[Index].ContainsQ(c) || m_Arcs[NextIndex(Index)].ContainsQ(c);
+    }
     if (!IsEmpty()) {
-        
-        // We go over each Arc until we find one that contains t.
-        for (int i = 0; i < m_DivPoints.size(); i++) {
-                if (m_Arcs[i].ContainsQ(c)) {
-                    return true;
-            }
-        }
+        return m_ArcArray.ContainsQ(c); // every Arc is checked
     } else
     {
         return true; // For an empty object, there is the whole Circle around each point, therefore it contains everything.
     }
-    return false; // In case we didn't find any, we return false.
+}
+
+
+
+
+// The total length of the Arcs. Arcs around neighbouring division points can be the same Arc, which is counted only once.
+template <typename Precision>
+typename Precision::real_type ArcsAroundDivPoints<Precision>::GetMeasure() const{
+    if (IsEmpty()) {
+        return 1;
+    }
+    floating_point_type Measure = 0;
+    int NumArcs = static_cast<int>(m_DivPoints.size());
+    for (int i = 0; i < NumArcs; i++) {
+        Arc CurrentArc = GetArc(i);
+        const CirclePoint& LeftEndpoint = CurrentArc.GetLeftEndpoint();
+        if (i == 0 || (LeftEndpoint != GetArc(i - 1).GetLeftEndpoint() && (i < NumArcs - 1 || LeftEndpoint != GetArc(0).GetLeftEndpoint()))) {
+            Measure += CurrentArc.GetLength();
+        }
+    }
+    return Measure;
+}
+
+
+
+
+
+template <typename Precision>
+typename Precision::real_type ArcsAroundDivPoints<Precision>::GetMaxArcLength() const{
+    if (IsEmpty()) {
+        return 1;
+    }
+    floating_point_type MaxLength = 0;
+    for (int i = 0; i < m_DivPoints.size(); i++) {
+        MaxLength = std::max(MaxLength, GetArc(i).GetLength());
+    }
+    return MaxLength;
 }
 
 
 
 
 // Inserts a new intersection point 
-void ArcsAroundDivPoints::InsertPoint(const CirclePoint& NewIntersectionPoint){
+template <typename Precision>
+void ArcsAroundDivPoints<Precision>::InsertPoint(const CirclePoint& NewIntersectionPoint){
     /*  The function works for all ArcsAroundDivPoints objects and for all NewIntersectionPoint as input, but there is
         one thing worth mentioning. Computers only have limited precision for floating point numbers, so in certain cases
         it might happen that the function doesn't do what we want.
@@ -65,13 +150,30 @@ void ArcsAroundDivPoints::InsertPoint(const CirclePoint& NewIntersectionPoint){
         a fixed precision, by taking longer and longer segments on a separatrix eventually it will always look like
         there is a saddle connection.)
     */
-    if (IsEmpty()) {
-        m_Arcs.resize(m_DivPoints.size(), Arc(NewIntersectionPoint));
+    if (IsEmpty() && m_AreDivPointsSorted) {
+        m_Arcs = SharedVector<Arc>(static_cast<int>(m_DivPoints.size()), Arc(NewIntersectionPoint));
 
-    } else { // if the object is not empty
-        for (int i = 0; i < m_DivPoints.size(); i++) {
-                m_Arcs[i].CutOff(m_DivPoints[i], NewIntersectionPoint);
+    } else if (IsEmpty()) {
+        m_ArcArray = ArcArray(m_DivPoints, NewIntersectionPoint);
+        
+    } else if (m_AreDivPointsSorted) {
+        // Only the Arc containing the new point is cut, walking left and right from it through its division points.
+        // An Arc that is already cut at the new point still contains it, but cutting it again does not change it.
+        // (The Arcs not containing the new point are never modified, so they stay shared with the copies.)
+        int NumDivPoints = static_cast<int>(m_DivPoints.size());
+        int Index = IndexBefore(NewIntersectionPoint);
+        int NumCut = 0;
+        for (int i = Index; NumCut < NumDivPoints && m_Arcs[i].ContainsQ(NewIntersectionPoint); i = i > 0 ? i - 1 : NumDivPoints - 1) {
+            m_Arcs.Modify(i).CutOff(m_DivPoints[i], NewIntersectionPoint);
+            NumCut++;
         }
+        for (int i = NextIndex(Index); NumCut < NumDivPoints && m_Arcs[i].ContainsQ(NewIntersectionPoint); i = NextIndex(i)) {
+            m_Arcs.Modify(i).CutOff(m_DivPoints[i], NewIntersectionPoint);
+            NumCut++;
+        }
+        
+    } else { // if the object is not empty
+        m_ArcArray.CutOff(NewIntersectionPoint);   // the Arcs not containing the point are not cut
     }
 }
 
@@ -80,7 +182,8 @@ void ArcsAroundDivPoints::InsertPoint(const CirclePoint& NewIntersectionPoint){
 
 
 // Prints out the DivPoints and all the Arcs.
-std::ostream& operator<<(std::ostream& Out, const ArcsAroundDivPoints& adp){
+template <typename Precision>
+std::ostream& operator<<(std::ostream& Out, const ArcsAroundDivPoints<Precision>& adp){
     using namespace std;
     
     Out << "Reference points: ";
@@ -93,7 +196,7 @@ std::ostream& operator<<(std::ostream& Out, const ArcsAroundDivPoints& adp){
         if (adp.IsEmpty()) {
             cout << "whole circle";
         } else {
-            cout << adp.m_Arcs[i];
+            cout << adp.GetArc(i);
         }
         cout << endl;
     }
@@ -103,7 +206,8 @@ std::ostream& operator<<(std::ostream& Out, const ArcsAroundDivPoints& adp){
 
 
 // Checks if the DivPoints in the two objects are the same. 
-bool IsSameDivPointType(const ArcsAroundDivPoints& adp1, const ArcsAroundDivPoints adp2)
+template <typename Precision>
+bool IsSameDivPointType(const ArcsAroundDivPoints<Precision>& adp1, const ArcsAroundDivPoints<Precision> adp2)
 {
     return adp1.m_DivPoints == adp2.m_DivPoints ? true : false;
 }
@@ -111,7 +215,8 @@ bool IsSameDivPointType(const ArcsAroundDivPoints& adp1, const ArcsAroundDivPoin
 
 
 // Takes the intersection of two ArcsAroundDivPoints by taking the union of intersection points in them
-ArcsAroundDivPoints Intersect(const ArcsAroundDivPoints& adp1, const ArcsAroundDivPoints& adp2)
+template <typename Precision>
+ArcsAroundDivPoints<Precision> Intersect(const ArcsAroundDivPoints<Precision>& adp1, const ArcsAroundDivPoints<Precision>& adp2)
 {
     
     if (!IsSameDivPointType(adp1, adp2)) {
@@ -125,11 +230,19 @@ ArcsAroundDivPoints Intersect(const ArcsAroundDivPoints& adp1, const ArcsAroundD
     if (adp2.IsEmpty()) {
         return adp1;
     }
-    const std::vector<CirclePoint>& DivPoints = adp1.m_DivPoints; // giving a non-assymetrical name
-    ArcsAroundDivPoints adp = adp1;
+    const std::vector<CirclePoint<Precision>>& DivPoints = adp1.m_DivPoints; // giving a non-assymetrical name
+    ArcsAroundDivPoints<Precision> adp = adp1;
+    if (!adp.m_AreDivPointsSorted) {
+        adp.m_ArcArray.CutOff(adp2.m_ArcArray);
+        return adp;
+    }
     for (int i = 0; i < adp1.m_DivPoints.size(); i++) {
-        adp.m_Arcs[i].CutOff(DivPoints[i], adp2.m_Arcs[i].GetLeftEndpoint());
-        adp.m_Arcs[i].CutOff(DivPoints[i], adp2.m_Arcs[i].GetRightEndpoint());
+        if (adp.m_Arcs[i].ContainsQ(adp2.m_Arcs[i].GetLeftEndpoint())) {
+            adp.m_Arcs.Modify(i).CutOff(DivPoints[i], adp2.m_Arcs[i].GetLeftEndpoint());
+        }
+        if (adp.m_Arcs[i].ContainsQ(adp2.m_Arcs[i].GetRightEndpoint())) {
+            adp.m_Arcs.Modify(i).CutOff(DivPoints[i], adp2.m_Arcs[i].GetRightEndpoint());
+        }
     }
     
     return adp;
@@ -137,7 +250,53 @@ ArcsAroundDivPoints Intersect(const ArcsAroundDivPoints& adp1, const ArcsAroundD
     
 
 
-bool ArcsAroundDivPoints::ContainsADivPoint(const Arc& arc) const{
+// For sorted division points the Arcs of the intersection are computed one by one as in Intersect, each on the stack,
+// and checked as in ContainsArcQ. The loop stops at the first Arc with an endpoint in arc. Otherwise the intersection is
+// built.
+template <typename Precision>
+bool IntersectionContainsArcThroughADivPointQ(const ArcsAroundDivPoints<Precision>& adp1, const ArcsAroundDivPoints<Precision>& adp2,
+                                              const Arc<Precision>& arc)
+{
+    if (adp1.IsEmpty()) {
+        return adp2.ContainsArcThroughADivPointQ(arc);
+    }
+    if (adp2.IsEmpty()) {
+        return adp1.ContainsArcThroughADivPointQ(arc);
+    }
+    if (!adp1.m_AreDivPointsSorted || (&adp1.m_DivPoints != &adp2.m_DivPoints && adp1.m_DivPoints != adp2.m_DivPoints)) {
+        return Intersect(adp1, adp2).ContainsArcThroughADivPointQ(arc);
+    }
+    if (!adp1.ContainsADivPoint(arc)) {      // does not depend on the Arcs
+        return false;
+    }
+    const std::vector<CirclePoint<Precision>>& DivPoints = adp1.m_DivPoints;
+    bool ContainsRightEndpoint = false;
+    for (int i = 0; i < DivPoints.size(); i++) {
+        Arc<Precision> CurrentArc = adp1.m_Arcs[i];
+        const Arc<Precision>& CuttingArc = adp2.m_Arcs[i];
+        if (CurrentArc.ContainsQ(CuttingArc.GetLeftEndpoint())) {
+            CurrentArc.CutOff(DivPoints[i], CuttingArc.GetLeftEndpoint());
+        }
+        if (CurrentArc.ContainsQ(CuttingArc.GetRightEndpoint())) {
+            CurrentArc.CutOff(DivPoints[i], CuttingArc.GetRightEndpoint());
+        }
+        if (arc.ContainsQ(CurrentArc.GetLeftEndpoint()) || arc.ContainsQ(CurrentArc.GetRightEndpoint())) {
+            return false;
+        }
+        ContainsRightEndpoint = ContainsRightEndpoint || CurrentArc.ContainsQ(arc.GetRightEndpoint());
+    }
+    return ContainsRightEndpoint;
+}
+    
+
+
+template <typename Precision>
+bool ArcsAroundDivPoints<Precision>::ContainsADivPoint(const Arc& arc) const{
+    if (m_AreDivPointsSorted) {
+        // the first division point to the right of the left endpoint is in the arc if any is
+        int Index = static_cast<int>(std::lower_bound(m_DivPoints.begin(), m_DivPoints.end(), arc.GetLeftEndpoint(), IsCoordinateLess) - m_DivPoints.begin());
+        return arc.ContainsQ(m_DivPoints[Index < m_DivPoints.size() ? Index : 0]);
+    }
     for (int i = 0; i < m_DivPoints.size(); i++) {
         if (arc.ContainsQ(m_DivPoints[i])) {
             return true;
@@ -150,14 +309,16 @@ bool ArcsAroundDivPoints::ContainsADivPoint(const Arc& arc) const{
 
 
 
-bool ArcsAroundDivPoints::ContainsArcQ(const Arc& arc) const{
+template <typename Precision>
+bool ArcsAroundDivPoints<Precision>::ContainsArcQ(const Arc& arc) const{
     for (int i = 0; i < m_DivPoints.size(); i++) {
-        if (arc.ContainsQ(m_Arcs[i].GetLeftEndpoint()) || arc.ContainsQ(m_Arcs[i].GetRightEndpoint())) {
+        Arc CurrentArc = GetArc(i);
+        if (arc.ContainsQ(CurrentArc.GetLeftEndpoint()) || arc.ContainsQ(CurrentArc.GetRightEndpoint())) {
             return false;
         }
     }
     for (int i = 0; i < m_DivPoints.size(); i++) {
-        if (m_Arcs[i].ContainsQ(arc.GetRightEndpoint())) {
+        if (GetArc(i).ContainsQ(arc.GetRightEndpoint())) {
             return true;
         }
     }
@@ -169,7 +330,8 @@ bool ArcsAroundDivPoints::ContainsArcQ(const Arc& arc) const{
 
 
 
-bool ArcsAroundDivPoints::ContainsArcThroughADivPointQ(const Arc& arc) const{
+template <typename Precision>
+bool ArcsAroundDivPoints<Precision>::ContainsArcThroughADivPointQ(const Arc& arc) const{
     if (ContainsArcQ(arc) && ContainsADivPoint(arc)) {
         return true;
     }
@@ -180,3 +342,12 @@ bool ArcsAroundDivPoints::ContainsArcThroughADivPointQ(const Arc& arc) const{
 
 
 
+#define INSTANTIATE_ARCS_AROUND_DIV_POINTS(Precision) \
+    template class ArcsAroundDivPoints<Precision>; \
+    template std::ostream& operator<<(std::ostream&, const ArcsAroundDivPoints<Precision>&); \
+    template bool IsSameDivPointType(const ArcsAroundDivPoints<Precision>&, const ArcsAroundDivPoints<Precision>); \
+    template ArcsAroundDivPoints<Precision> Intersect(const ArcsAroundDivPoints<Precision>&, const ArcsAroundDivPoints<Precision>&); \
+    template bool IntersectionContainsArcThroughADivPointQ(const ArcsAroundDivPoints<Precision>&, const ArcsAroundDivPoints<Precision>&, \
+                                                           const Arc<Precision>&);
+
+FOR_EACH_PRECISION(INSTANTIATE_ARCS_AROUND_DIV_POINTS)
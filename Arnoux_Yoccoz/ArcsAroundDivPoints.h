@@ -66,7 +66,7 @@
     CLASS DETIALS: 
                 
                 1. m_DivPoints. This is the array of division points on the circle. In the application of this class to
-                    the RP^2 case these points are sorted, but they are not assumed to be.
+                    the RP^2 case these points are sorted, but they are not assumed to be. (See 4.)
                     Memory for m_DivPoints is not allocated by the object, and m_DivPoints is not stored by the object.
                     The input is simply the pointer to the array of division points in the foliation. Since a lot of 
                     ArcsAroundDivPoints objects are handles for the same foliation and therefore the same set of 
@@ -84,6 +84,18 @@
                     no Arcs are stored. Once the first intersection point is added, m_IsEmpty becomes false and Arcs 
                     are initialized.
  
+                4. Sorted division points. If the coordinates of m_DivPoints are increasing (m_AreDivPointsSorted), then
+                    a point of the Circle is between two consecutive division points, found by binary search, and any
+                    Arc containing it contains one of these two division points as well. Since the division points in an
+                    Arc are consecutive, a new intersection point cuts only the Arcs of the consecutive division points
+                    going left and right from there, and the rest of the Arcs are not even looked at. Containment queries
+                    only need to look at the Arcs of the two division points. Otherwise every Arc is checked, and the
+                    Arcs are kept in an ArcArray (m_ArcArray) instead of m_Arcs, which checks several Arcs at once.
+ 
+                5. Copies. Objects are copied with their separatrix segments, and a new intersection point changes only a
+                    few Arcs, so m_Arcs is a SharedVector: the copies share the Arcs that have not changed since copying.
+                    (An m_ArcArray is copied whole, but there every Arc can change anyway.)
+ 
  
     POSSIBLE IMPROVEMENTS:
                 
@@ -107,37 +119,59 @@
 #include <iostream>
 #include <vector>
 #include "Arc.h"
+#include "SharedVector.h"
+#include "ArcArray.h"
 
 
 
 
+template <typename Precision = DefaultPrecision>
 class ArcsAroundDivPoints{
 public:
+    typedef typename Precision::real_type floating_point_type;
+    typedef ::CirclePoint<Precision> CirclePoint;
+    typedef ::Arc<Precision> Arc;
+    typedef ::ArcArray<Precision> ArcArray;
     
-    ArcsAroundDivPoints(const std::vector<CirclePoint>& DivPoints) : m_DivPoints(DivPoints) {}   // contructor empty object
+    ArcsAroundDivPoints(const std::vector<CirclePoint>& DivPoints) : m_DivPoints(DivPoints), m_AreDivPointsSorted(AreSorted(DivPoints)) {}   // contructor empty object
+    ArcsAroundDivPoints(const ArcsAroundDivPoints& adp) = default;     // the copy has the same DivPoints
+    ArcsAroundDivPoints& operator=(const ArcsAroundDivPoints& adp);    // assignment operator, only between objects of the same DivPoints
 
   //  void Init(CirclePoint DivPoints[], int NumDivPoints);        // Initializing values for empty object
     void InsertPoint(const CirclePoint& NewIntersectionPoint);  // Inserts a new intersection point
     bool ContainsQ(const CirclePoint& c) const;                 // Decides if a point is contained in any of the Arcs around the division points
     
     // Takes the intersection of two ArcsAroundDivPoints by taking the union of intersection points in them
-    friend ArcsAroundDivPoints Intersect(const ArcsAroundDivPoints& adp1, const ArcsAroundDivPoints& adp2);
+    template <typename P> friend ArcsAroundDivPoints<P> Intersect(const ArcsAroundDivPoints<P>& adp1, const ArcsAroundDivPoints<P>& adp2);
     bool ContainsArcThroughADivPointQ(const Arc&) const;
-    friend std::ostream& operator<<(std::ostream& Out, const ArcsAroundDivPoints& adp); // Prints out the DivPoints and all the Arcs.
+    // The same as Intersect(adp1, adp2).ContainsArcThroughADivPointQ(arc), without building the intersection
+    template <typename P> friend bool IntersectionContainsArcThroughADivPointQ(const ArcsAroundDivPoints<P>& adp1, const ArcsAroundDivPoints<P>& adp2,
+                                                                               const ::Arc<P>& arc);
+    std::vector<Arc> GetArcs() const{ return m_AreDivPointsSorted ? m_Arcs.ToVector() : m_ArcArray.GetArcs(); }  // the Arc around each division point, none for an empty object
+    void SetArcs(const std::vector<Arc>& Arcs);                // the reverse of GetArcs, e.g. for an object read from a file
+    floating_point_type GetMeasure() const;                     // the total length of the Arcs, counting each Arc once
+    floating_point_type GetMaxArcLength() const;                // the length of the longest Arc, 1 for an empty object
+    template <typename P> friend std::ostream& operator<<(std::ostream& Out, const ArcsAroundDivPoints<P>& adp); // Prints out the DivPoints and all the Arcs.
 
 private:
 
     const std::vector<CirclePoint>& m_DivPoints;   // the array of division points, ENRTIES NOT TO BE CHANGED BY THIS OBJECT!
-    std::vector<Arc> m_Arcs;               // the array of Arcs around division points
+    SharedVector<Arc> m_Arcs;              // the array of Arcs around division points, shared with the copies (see 5.)
+    ArcArray m_ArcArray;                   // the Arcs instead of m_Arcs if the division points are not sorted (see 4.)
+    bool m_AreDivPointsSorted;             // if the coordinates of m_DivPoints are increasing, see 4. above
     
-    inline bool IsEmpty() const { return m_Arcs.size() == 0 ? true : false; }
+    inline bool IsEmpty() const { return m_Arcs.Size() == 0 && m_ArcArray.Size() == 0 ? true : false; }
+    inline Arc GetArc(int Index) const{ return m_AreDivPointsSorted ? m_Arcs[Index] : m_ArcArray.GetArc(Index); }
+    static bool AreSorted(const std::vector<CirclePoint>& DivPoints);
+    static bool IsCoordinateLess(const CirclePoint& c1, const CirclePoint& c2){ return c1.GetCoordinate() < c2.GetCoordinate(); }
+    int IndexBefore(const CirclePoint& c) const;     // the last division point not to the right of c, for sorted division points
+    inline int NextIndex(int Index) const{ return Index < m_DivPoints.size() - 1 ? Index + 1 : 0; }
     bool ContainsADivPoint(const Arc&) const;
     bool ContainsArcQ(const Arc&) const;
     
     // Checks if the DivPoints in the two objects are the same
-    friend bool IsSameDivPointType(const ArcsAroundDivPoints& adp1, const ArcsAroundDivPoints adp2);
+    template <typename P> friend bool IsSameDivPointType(const ArcsAroundDivPoints<P>& adp1, const ArcsAroundDivPoints<P> adp2);
     
-  //  ArcsAroundDivPoints& operator=(const ArcsAroundDivPoints& adp);                     // assignment operator
   //  ArcsAroundDivPoints() {}      // default constructor
 
 };
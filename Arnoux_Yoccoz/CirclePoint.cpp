@@ -13,7 +13,8 @@
 
 
 
-bool operator<(const CirclePoint& c1, const CirclePoint& c2){
+template <typename Precision>
+bool operator<(const CirclePoint<Precision>& c1, const CirclePoint<Precision>& c2){
     if(c1.m_Value < c2.m_Value)
         return true;
     if(c1.m_Value > c2.m_Value)
@@ -24,8 +25,9 @@ bool operator<(const CirclePoint& c1, const CirclePoint& c2){
 }
 
 
-std::ostream& operator<<(std::ostream& Out, const CirclePoint& c){
-    Out << c.m_Value;
+template <typename Precision>
+std::ostream& operator<<(std::ostream& Out, const CirclePoint<Precision>& c){
+    Out << c.GetValue();
     switch(c.m_Side){
         case RIGHT: Out << "(+)";
             break;
@@ -37,7 +39,8 @@ std::ostream& operator<<(std::ostream& Out, const CirclePoint& c){
     return Out;
 }
 
-bool IsBetween(const CirclePoint& cLeft, const CirclePoint& cRight, const CirclePoint& cThird)
+template <typename Precision>
+bool IsBetween(const CirclePoint<Precision>& cLeft, const CirclePoint<Precision>& cRight, const CirclePoint<Precision>& cThird)
 {
     
     if (cLeft <= cThird && cThird <= cRight) {
@@ -51,7 +54,21 @@ bool IsBetween(const CirclePoint& cLeft, const CirclePoint& cRight, const Circle
 }
 
 
-floating_point_type DistanceBetween(const CirclePoint& c1, const CirclePoint& c2)
+template <typename Precision>
+typename Precision::real_type DistanceBetween(const CirclePoint<Precision>& c1, const CirclePoint<Precision>& c2)
 {
-    return c1.m_Value <= c2.m_Value ? c2.m_Value - c1.m_Value : c2.m_Value - c1.m_Value + 1;
-}
\ No newline at end of file
+    return CirclePoint<Precision>::Coordinate::template DistanceToTheRight<typename Precision::real_type>(c1.m_Value, c2.m_Value);
+}
+
+
+
+
+
+#define INSTANTIATE_CIRCLE_POINT(Precision) \
+    template class CirclePoint<Precision>; \
+    template bool operator<(const CirclePoint<Precision>&, const CirclePoint<Precision>&); \
+    template std::ostream& operator<<(std::ostream&, const CirclePoint<Precision>&); \
+    template bool IsBetween(const CirclePoint<Precision>&, const CirclePoint<Precision>&, const CirclePoint<Precision>&); \
+    template Precision::real_type DistanceBetween(const CirclePoint<Precision>&, const CirclePoint<Precision>&);
+
+FOR_EACH_PRECISION(INSTANTIATE_CIRCLE_POINT)
\ No newline at end of file
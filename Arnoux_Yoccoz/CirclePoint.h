@@ -7,6 +7,11 @@
  *  DESCRIPTION: A point of the circle of circumference 1.
  
     MORE DETAILS: Point are encoded with one real number m_Value, such that 0<=m_Value<1
+ 
+                The type of m_Value is the coordinate type of the Precision policy (see Precision.h).
+                Usually it is a floating point type, but it can be a fixed point representation
+                (see FixedPoint.h), in which going around the circle is exact. Lengths and distances
+                are always of the real type of the policy.
         
     POSSIBLE IMPROVEMENTS:
                 1. We could introduce generalized points which are infinitesimally close
@@ -23,8 +28,7 @@
 
 #include <iostream>
 #include <cmath>
-
-typedef long double floating_point_type;
+#include "Precision.h"
 
 enum LeftOrRight{
     LEFT = 0,
@@ -46,22 +50,43 @@ inline LeftOrRight Opposite(LeftOrRight x){
     }
 }
 
-// The fractional part of any real number. Works for negatives, too: FracPart(-0.3)=0.7.
-inline floating_point_type FracPart(floating_point_type t){ return t - floor(t); }
+inline LeftOrRight operator++(LeftOrRight& x, int){ LeftOrRight Old = x; x = static_cast<LeftOrRight>(x + 1); return Old; }
 
+
+template <typename Precision = DefaultPrecision>
 class CirclePoint {        
 public:
+    typedef typename Precision::real_type floating_point_type;
+    typedef typename Precision::coordinate_type circle_coordinate_type;
+    typedef CoordinateTraits<circle_coordinate_type> Coordinate;
+
     CirclePoint() { }
-    CirclePoint(floating_point_type t) : m_Value(FracPart(t)), m_Side(CENTER) {}        // usual constructor for an ordinary point
-    CirclePoint(floating_point_type t, LeftOrRight Side) : m_Value(FracPart(t)), m_Side(Side) {}      // constructor for a generalized point
+    CirclePoint(floating_point_type t) : m_Value(Coordinate::FromReal(t)), m_Side(CENTER) {}        // usual constructor for an ordinary point
+    CirclePoint(floating_point_type t, LeftOrRight Side) : m_Value(Coordinate::FromReal(t)), m_Side(Side) {}      // constructor for a generalized point
     
+    // constructor from a coordinate that is not necessarily reduced modulo 1
+    static CirclePoint FromCoordinate(const circle_coordinate_type& t, LeftOrRight Side = CENTER){
+        CirclePoint c;
+        c.m_Value = Coordinate::Reduce(t);
+        c.m_Side = Side;
+        return c;
+    }
+    
+    // constructor from a coordinate that is already reduced, e.g. one returned by GetCoordinate
+    static CirclePoint FromReducedCoordinate(const circle_coordinate_type& t, LeftOrRight Side = CENTER){
+        CirclePoint c;
+        c.m_Value = t;
+        c.m_Side = Side;
+        return c;
+    }
     
-    inline const floating_point_type& GetValue() const { return m_Value; }     // Returns m_Value in actual number type
+    inline floating_point_type GetValue() const { return Coordinate::template ToReal<floating_point_type>(m_Value); }     // Returns m_Value in actual number type
+    inline const circle_coordinate_type& GetCoordinate() const { return m_Value; }     // Returns m_Value in its own type, for exact comparisons
 
     
-    inline CirclePoint Antipodal() const{ return CirclePoint(m_Value + 0.5, m_Side); }       // Returns the antipodal of the point
-    inline CirclePoint Centered() const{ return CirclePoint(m_Value); }
-    inline CirclePoint ShiftedTo(LeftOrRight Side) const{ return CirclePoint(m_Value, Side); }
+    inline CirclePoint Antipodal() const{ return FromCoordinate(m_Value + Coordinate::Half(), m_Side); }       // Returns the antipodal of the point
+    inline CirclePoint Centered() const{ return FromCoordinate(m_Value); }
+    inline CirclePoint ShiftedTo(LeftOrRight Side) const{ return FromCoordinate(m_Value, Side); }
     
     inline void Shift(LeftOrRight Side) { m_Side = Side; }
     inline bool IsShiftedTo(LeftOrRight Side) const{ return m_Side == Side ? true : false;}
@@ -69,38 +94,39 @@ public:
 
     
     // Returns the distance between c1 and c2. It looks for c2 on the RIGHT of c1, so the return value may be bigger than 0.5.
-    friend floating_point_type DistanceBetween(const CirclePoint& c1, const CirclePoint& c2);
+    template <typename P> friend typename P::real_type DistanceBetween(const CirclePoint<P>& c1, const CirclePoint<P>& c2);
     
     // Decides if cThird is between cLeft and cRight (to the right from cLeft and the left from cRight)
     // I.e. (0.5, 0.2, 0.1) returns true, but (0.5, 0.2, 0.4) returns false
-    friend bool IsBetween(const CirclePoint& cLeft, const CirclePoint& cRight, const CirclePoint& cThird);
+    template <typename P> friend bool IsBetween(const CirclePoint<P>& cLeft, const CirclePoint<P>& cRight, const CirclePoint<P>& cThird);
     
 
 
-    // Shifts the point c into the positive direction by Distance
-    inline friend CirclePoint operator+(const CirclePoint& c, floating_point_type Distance){
-        return CirclePoint(c.m_Value + Distance, c.m_Side);
+    // Shifts the point c into the positive direction by Distance. A floating point Distance has to be converted
+    // by circle_coordinate_type(Distance) first.
+    inline friend CirclePoint operator+(const CirclePoint& c, const circle_coordinate_type& Distance){
+        return FromCoordinate(c.m_Value + Distance, c.m_Side);
     }
     
     // Shifts the point c into the negative direction by Distance
-    inline friend CirclePoint operator-(const CirclePoint& c, floating_point_type Distance){ return CirclePoint(c.m_Value - Distance, c.m_Side); }
-    inline friend CirclePoint operator-(const CirclePoint& c){ return CirclePoint(-c.m_Value, Opposite(c.m_Side)); }
+    inline friend CirclePoint operator-(const CirclePoint& c, const circle_coordinate_type& Distance){ return FromCoordinate(c.m_Value - Distance, c.m_Side); }
+    inline friend CirclePoint operator-(const CirclePoint& c){ return FromCoordinate(-c.m_Value, Opposite(c.m_Side)); }
     inline friend bool operator==(const CirclePoint& c1, const CirclePoint& c2){
         return c1.m_Value == c2.m_Value && c1.m_Side == c2.m_Side ? true : false;
     }
     inline friend bool operator!=(const CirclePoint& c1, const CirclePoint& c2){ return c1 == c2 ? false : true; }
 
 
-    friend std::ostream& operator<<(std::ostream& Out, const CirclePoint& c);
+    template <typename P> friend std::ostream& operator<<(std::ostream& Out, const CirclePoint<P>& c);
 
     
     
 private:
-    floating_point_type m_Value; // the point is described by this number, at least 0 and less than 1
+    circle_coordinate_type m_Value; // the point is described by this number, at least 0 and less than 1
     LeftOrRight m_Side;
     
     
-    inline friend bool operator<(const CirclePoint& c1, const CirclePoint& c2);
+    template <typename P> friend bool operator<(const CirclePoint<P>& c1, const CirclePoint<P>& c2);
     inline friend bool operator<=(const CirclePoint& c1, const CirclePoint& c2){ return c1 < c2 || c1 == c2 ? true : false;}
 };
 
@@ -0,0 +1,106 @@
+/*******************************************************************************
+ *  CLASS NAME:	DoubleDouble
+ *  AUTHOR:		Balazs Strenner
+ *				Copyright 2013 UW-Madison. All rights reserved.
+ *
+ *  DESCRIPTION: A real number represented as the unevaluated sum of two doubles, m_Hi + m_Lo,
+                with |m_Lo| at most half a unit in the last place of m_Hi. This gives about 106 bits
+                of precision using only double arithmetic.
+
+    MORE DETAILS: The arithmetic is the usual one based on the exact TwoSum and TwoProduct
+                transformations (see Dekker, Knuth, or the QD library of Hida, Li and Bailey).
+                TwoProduct uses std::fma, which is exact even where there is no hardware instruction
+                for it, only slower.
+
+ ******************************************************************************/
+
+#ifndef ArnouxYoccoz_DoubleDouble_h
+#define ArnouxYoccoz_DoubleDouble_h
+
+#include <iostream>
+#include <cmath>
+
+
+class DoubleDouble {
+public:
+    DoubleDouble() {}
+    DoubleDouble(int t) : m_Hi(t), m_Lo(0) {}
+    DoubleDouble(double t) : m_Hi(t), m_Lo(0) {}
+    DoubleDouble(long double t) : m_Hi(static_cast<double>(t)), m_Lo(static_cast<double>(t - static_cast<double>(t))) {}
+
+    inline double GetHi() const{ return m_Hi; }
+    inline double GetLo() const{ return m_Lo; }
+    explicit operator long double() const{ return static_cast<long double>(m_Hi) + m_Lo; }
+    explicit operator double() const{ return m_Hi; }
+
+    friend DoubleDouble operator+(const DoubleDouble& a, const DoubleDouble& b){
+        double s, e;
+        TwoSum(a.m_Hi, b.m_Hi, s, e);
+        double t, f;
+        TwoSum(a.m_Lo, b.m_Lo, t, f);
+        e += t;
+        QuickTwoSum(s, e, s, e);
+        e += f;
+        return Normalized(s, e);
+    }
+    friend DoubleDouble operator-(const DoubleDouble& a){ return Normalized(-a.m_Hi, -a.m_Lo); }
+    friend DoubleDouble operator-(const DoubleDouble& a, const DoubleDouble& b){ return a + (-b); }
+    friend DoubleDouble operator*(const DoubleDouble& a, const DoubleDouble& b){
+        double p = a.m_Hi * b.m_Hi;
+        double e = std::fma(a.m_Hi, b.m_Hi, -p);
+        e += a.m_Hi * b.m_Lo + a.m_Lo * b.m_Hi;
+        return Normalized(p, e);
+    }
+    friend DoubleDouble operator/(const DoubleDouble& a, const DoubleDouble& b){
+        double q1 = a.m_Hi / b.m_Hi;
+        DoubleDouble r = a - b * DoubleDouble(q1);
+        double q2 = r.m_Hi / b.m_Hi;
+        r = r - b * DoubleDouble(q2);
+        double q3 = r.m_Hi / b.m_Hi;
+        return Normalized(q1, q2) + DoubleDouble(q3);
+    }
+
+    DoubleDouble& operator+=(const DoubleDouble& b){ return *this = *this + b; }
+    DoubleDouble& operator-=(const DoubleDouble& b){ return *this = *this - b; }
+    DoubleDouble& operator*=(const DoubleDouble& b){ return *this = *this * b; }
+    DoubleDouble& operator/=(const DoubleDouble& b){ return *this = *this / b; }
+
+    friend bool operator==(const DoubleDouble& a, const DoubleDouble& b){ return a.m_Hi == b.m_Hi && a.m_Lo == b.m_Lo; }
+    friend bool operator!=(const DoubleDouble& a, const DoubleDouble& b){ return !(a == b); }
+    friend bool operator<(const DoubleDouble& a, const DoubleDouble& b){ return a.m_Hi < b.m_Hi || (a.m_Hi == b.m_Hi && a.m_Lo < b.m_Lo); }
+    friend bool operator>(const DoubleDouble& a, const DoubleDouble& b){ return b < a; }
+    friend bool operator<=(const DoubleDouble& a, const DoubleDouble& b){ return !(b < a); }
+    friend bool operator>=(const DoubleDouble& a, const DoubleDouble& b){ return !(a < b); }
+
+    friend DoubleDouble Floor(const DoubleDouble& t){
+        double Hi = std::floor(t.m_Hi);
+        return Hi == t.m_Hi ? Normalized(Hi, std::floor(t.m_Lo)) : DoubleDouble(Hi);
+    }
+    friend DoubleDouble Abs(const DoubleDouble& t){ return t.m_Hi < 0 ? -t : t; }
+
+    // Only the first 64 bits are printed.
+    friend std::ostream& operator<<(std::ostream& Out, const DoubleDouble& t){ return Out << static_cast<long double>(t); }
+
+private:
+    double m_Hi;
+    double m_Lo;
+
+    static DoubleDouble Normalized(double Hi, double Lo){ DoubleDouble t; QuickTwoSum(Hi, Lo, t.m_Hi, t.m_Lo); return t; }
+
+    // s + e = a + b exactly, s = fl(a + b)
+    static void TwoSum(double a, double b, double& s, double& e){
+        s = a + b;
+        double bb = s - a;
+        e = (a - (s - bb)) + (b - bb);
+    }
+    // same as TwoSum, assuming |a| >= |b|
+    static void QuickTwoSum(double a, double b, double& s, double& e){
+        s = a + b;
+        e = b - (s - a);
+    }
+};
+
+
+
+
+#endif
@@ -0,0 +1,99 @@
+/*******************************************************************************
+ *  CLASS NAME:	FixedPoint
+ *  AUTHOR:		Balazs Strenner
+ *				Copyright 2013 UW-Madison. All rights reserved.
+ *
+ *  DESCRIPTION: A number modulo 1, stored as an unsigned integer Word counting
+                multiples of 2^(-number of bits of Word).
+
+    MORE DETAILS: This is an alternative to floating point numbers for the coordinates of
+                CirclePoints. Going around the circle is just the overflow of the unsigned integer,
+                so the fractional part never has to be computed, the antipodal point is obtained by
+                adding 2^(n-1), and comparisons are integer comparisons. Every point of the circle is
+                represented with the same absolute precision, unlike floating point numbers, which are
+                much more precise near 0 than near 1.
+
+                Only the conversion from and to floating point numbers is inexact, and that only happens
+                when a foliation is set up from the lengths of its Intervals or when a length is
+                reported back. FixedPoint coordinates are selected by the precision policy, see Precision.h.
+
+ ******************************************************************************/
+
+#ifndef ArnouxYoccoz_FixedPoint_h
+#define ArnouxYoccoz_FixedPoint_h
+
+#include <iostream>
+#include <cmath>
+#include <stdint.h>
+
+
+template <typename Word>
+class FixedPoint {
+public:
+    FixedPoint() {}
+    template <typename Real>
+    explicit FixedPoint(const Real& t);     // the fractional part of t, rounded down to the nearest representable value
+    static FixedPoint FromRaw(Word Raw){ FixedPoint f; f.m_Raw = Raw; return f; }
+    static FixedPoint Max(){ return FromRaw(~Word(0)); } // the largest representable value, 1 - 2^(-NUM_BITS)
+
+    inline const Word& GetRaw() const{ return m_Raw; }
+    template <typename Real>
+    Real ToReal() const;
+
+    inline friend FixedPoint operator+(const FixedPoint& a, const FixedPoint& b){ return FromRaw(a.m_Raw + b.m_Raw); }
+    inline friend FixedPoint operator-(const FixedPoint& a, const FixedPoint& b){ return FromRaw(a.m_Raw - b.m_Raw); }
+    inline friend FixedPoint operator-(const FixedPoint& a){ return FromRaw(-a.m_Raw); }
+
+    inline friend bool operator==(const FixedPoint& a, const FixedPoint& b){ return a.m_Raw == b.m_Raw; }
+    inline friend bool operator!=(const FixedPoint& a, const FixedPoint& b){ return a.m_Raw != b.m_Raw; }
+    inline friend bool operator<(const FixedPoint& a, const FixedPoint& b){ return a.m_Raw < b.m_Raw; }
+    inline friend bool operator>(const FixedPoint& a, const FixedPoint& b){ return a.m_Raw > b.m_Raw; }
+    inline friend bool operator<=(const FixedPoint& a, const FixedPoint& b){ return a.m_Raw <= b.m_Raw; }
+    inline friend bool operator>=(const FixedPoint& a, const FixedPoint& b){ return a.m_Raw >= b.m_Raw; }
+
+    friend std::ostream& operator<<(std::ostream& Out, const FixedPoint& f){ return Out << f.template ToReal<long double>(); }
+
+private:
+    Word m_Raw;
+    static const int NUM_BITS = sizeof(Word) * 8;
+};
+
+
+typedef FixedPoint<uint64_t> FixedPoint64;
+#ifdef __SIZEOF_INT128__
+typedef FixedPoint<unsigned __int128> FixedPoint128;
+#endif
+
+
+
+// The digits are extracted 32 bits at a time, so that the same code works for 128 bit Words and for any Real
+// that has Floor (see Precision.h) and can be converted to long double.
+template <typename Word>
+template <typename Real>
+FixedPoint<Word>::FixedPoint(const Real& t){
+    Real Remainder = t - Floor(t);
+    m_Raw = 0;
+    for (int i = 0; i < NUM_BITS / 32; i++) {
+        Remainder *= 4294967296.0;
+        Real Digits = Floor(Remainder);
+        Remainder -= Digits;
+        m_Raw = (m_Raw << 32) | static_cast<uint32_t>(static_cast<long double>(Digits));
+    }
+}
+
+
+template <typename Word>
+template <typename Real>
+Real FixedPoint<Word>::ToReal() const{
+    Real Value = 0;
+    Word Raw = m_Raw;
+    for (int i = 0; i < NUM_BITS / 32; i++) {
+        Value = (Value + Real(static_cast<double>(static_cast<uint32_t>(Raw & 0xFFFFFFFFu)))) / Real(4294967296.0);
+        Raw >>= 32;
+    }
+    return Value;
+}
+
+
+
+#endif
@@ -10,10 +10,14 @@
  ******************************************************************************/
 
 #include "FoliationDisk.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
 
 
 
-FoliationDisk::FoliationDisk(const WeighedTree& wt):
+template <typename Precision>
+FoliationDisk<Precision>::FoliationDisk(const WeighedTree& wt):
 m_NumSeparatrices(2 * wt.m_Root->m_NumDescendants),
 m_Lengths(m_NumSeparatrices),
 m_Pair(m_NumSeparatrices)
@@ -24,7 +28,8 @@ m_Pair(m_NumSeparatrices)
 
 
 
-FoliationDisk::FoliationDisk(const std::vector<floating_point_type>& Lengths, const std::vector<int>& Pair) :
+template <typename Precision>
+FoliationDisk<Precision>::FoliationDisk(const std::vector<floating_point_type>& Lengths, const std::vector<int>& Pair) :
 m_NumSeparatrices(static_cast<int>(Lengths.size())),
 m_Lengths(Lengths),
 m_Pair(Pair)
@@ -36,17 +41,56 @@ m_Pair(Pair)
 
 
 // Initializes variables once m_NumSeparatrices, m_Lengths and m_Pair are defined
-void FoliationDisk::Init(){
+template <typename Precision>
+void FoliationDisk<Precision>::Init(){
     NormalizeLengths();
     m_DivPoints.resize(m_NumSeparatrices);
     m_DivPoints[0] = CirclePoint(0);
     for (int i = 0; i < m_NumSeparatrices - 1; i++) { // Initialize mDivPoints
-        m_DivPoints[i + 1] = m_DivPoints[i] + m_Lengths[i];
+        m_DivPoints[i + 1] = m_DivPoints[i] + circle_coordinate_type(m_Lengths[i]);
     }
     m_TempForFollowTheLeaf.resize(m_NumSeparatrices);
     for (int i = 0; i < m_NumSeparatrices; i++) {
-        m_TempForFollowTheLeaf[i] = m_DivPoints[m_Pair[i]].GetValue() + m_DivPoints[IncreaseIndex(i)].GetValue();
+        m_TempForFollowTheLeaf[i] = m_DivPoints[m_Pair[i]].GetCoordinate() + m_DivPoints[IncreaseIndex(i)].GetCoordinate();
     }
+    m_DivPointCoordinates.resize(m_NumSeparatrices + 1);
+    for (int i = 0; i <= m_NumSeparatrices; i++) {
+        m_DivPointCoordinates[i] = m_DivPoints[i < m_NumSeparatrices ? i : 0].GetCoordinate();
+    }
+    InitEytzingerDivPoints();
+}
+
+
+
+// Lays out m_DivPoints[1], ..., m_DivPoints[m_NumSeparatrices - 1] as a complete binary search tree in breadth-first
+// (Eytzinger) order, padded at the end with values that are not less than any point of the circle. Searching the tree
+// then needs no branches, and the first few levels, which every search goes through, share a few cache lines.
+template <typename Precision>
+void FoliationDisk<Precision>::InitEytzingerDivPoints(){
+    m_EytzingerDepth = 0;
+    while ((1 << m_EytzingerDepth) - 1 < m_NumSeparatrices - 1) {
+        m_EytzingerDepth++;
+    }
+    int TreeSize = (1 << m_EytzingerDepth) - 1;
+    std::vector<circle_coordinate_type> SortedValues(TreeSize, CirclePoint::Coordinate::UpperBound());
+    for (int i = 1; i < m_NumSeparatrices; i++) {
+        SortedValues[i - 1] = m_DivPoints[i].GetCoordinate();
+    }
+    m_EytzingerDivPoints.resize(TreeSize + 1); // the root is at index 1, index 0 is not used
+    FillEytzingerDivPoints(SortedValues, 0, 1);
+}
+
+
+
+// Fills in the subtree under TreeIndex in-order from SortedValues, starting at SortedIndex. Returns the next unused SortedIndex.
+template <typename Precision>
+int FoliationDisk<Precision>::FillEytzingerDivPoints(const std::vector<circle_coordinate_type>& SortedValues, int SortedIndex, int TreeIndex){
+    if (TreeIndex < m_EytzingerDivPoints.size()) {
+        SortedIndex = FillEytzingerDivPoints(SortedValues, SortedIndex, 2 * TreeIndex);
+        m_EytzingerDivPoints[TreeIndex] = SortedValues[SortedIndex++];
+        SortedIndex = FillEytzingerDivPoints(SortedValues, SortedIndex, 2 * TreeIndex + 1);
+    }
+    return SortedIndex;
 }
 
 
@@ -87,7 +131,8 @@ void AssertRangeIsClosedUnderPair(const std::vector<int>& Pair, int begin, int e
 
 
 
-void FoliationDisk::FillInLengthsAndPair(int StartingIndex, WeighedTree::Node* pNode){
+template <typename Precision>
+void FoliationDisk<Precision>::FillInLengthsAndPair(int StartingIndex, WeighedTree::Node* pNode){
     int ChildrenStartingIndex = StartingIndex;
     for (int i = 0; i < pNode->m_NumChildren; i++) {
         int pair = ChildrenStartingIndex + 2 * pNode->m_Children[i].m_NumDescendants + 1;
@@ -100,7 +145,8 @@ void FoliationDisk::FillInLengthsAndPair(int StartingIndex, WeighedTree::Node* p
 }
 
 
-void FoliationDisk::AverageLengths(){
+template <typename Precision>
+void FoliationDisk<Precision>::AverageLengths(){
     for (int i = 0; i < m_NumSeparatrices; i++) {
         if (m_Pair[i] > i) {
             floating_point_type Average = (m_Lengths[i] + m_Lengths[m_Pair[i]])/2;
@@ -112,7 +158,8 @@ void FoliationDisk::AverageLengths(){
 
 
 
-void FoliationDisk::NormalizeLengths(){
+template <typename Precision>
+void FoliationDisk<Precision>::NormalizeLengths(){
     floating_point_type TotalLength = 0;
     for (int i = 0; i < m_NumSeparatrices; i++) {
         TotalLength += m_Lengths[i];
@@ -133,22 +180,88 @@ void FoliationDisk::NormalizeLengths(){
 
 
 // The point we get by following the leaf from t until we hit the boundary circle again.
-CirclePoint FoliationDisk::FollowTheLeaf(const CirclePoint& t){
+template <typename Precision>
+CirclePoint<Precision> FoliationDisk<Precision>::FollowTheLeaf(const CirclePoint& t) const{
     return -t + m_TempForFollowTheLeaf[WhichIntervalContains(t)];
 } 
 
 
-int FoliationDisk::FindBetweenShiftedDivPoints(const CirclePoint& t, int StartIndex, int EndIndex){
-    return 0;
+
+// Finds the Interval containing t and decides if t is a division point with a single lookup.
+// A division point is always an endpoint of the Interval returned by WhichIntervalContains.
+template <typename Precision>
+typename FoliationDisk<Precision>::LeafStep FoliationDisk<Precision>::Locate(const CirclePoint& t) const{
+    LeafStep Step;
+    Step.m_Point = t;
+    Step.m_IntervalIndex = WhichIntervalContains(t);
+    Step.m_IsDivPoint = m_DivPoints[Step.m_IntervalIndex].GetCoordinate() == t.GetCoordinate() ||
+                        m_DivPoints[IncreaseIndex(Step.m_IntervalIndex)].GetCoordinate() == t.GetCoordinate();
+    return Step;
 }
 
 
-int FoliationDisk::WhichIntervalContainsNew(const CirclePoint& t){
-    int Index = FindBetweenShiftedDivPoints(t, 0, 2 * m_NumSeparatrices);
-    if (Index % 2 == 1) {
-        return Index/2;
-    } else
-        throw ExceptionThePointIsADivPoint();
+
+// The next intersection of the leaf through t with the boundary circle: either the antipodal point (when the leaf is coming
+// from the other side of the boundary circle in RP^2), or the point we get by following the leaf inside the disk.
+// IntervalIndex must be the index of the Interval containing t, as returned by an earlier Locate or NextIntersection. This way
+// a step of a leaf costs only one lookup, the one for the new point.
+template <typename Precision>
+typename FoliationDisk<Precision>::LeafStep FoliationDisk<Precision>::NextIntersection(const CirclePoint& t, int IntervalIndex, bool Antipodal) const{
+    return Locate(Antipodal ? t.Antipodal() : -t + m_TempForFollowTheLeaf[IntervalIndex]);
+}
+
+
+
+
+// The same as calling NextIntersection for each lane of Batch, and storing the result back in the lane. Every lane goes
+// through the same operations, one phase at a time: first the steps, then the levels of the Eytzinger search (or the
+// comparisons with the division points for few separatrices), then the check for division points. There is no branch
+// that depends on the lane, so for number types with vector instructions (double, FixedPoint64) the compiler can run the
+// lanes side by side, with gathered loads for the table lookups.
+// The arithmetic is done in the same order as in CirclePoint, so the results agree with NextIntersection bit for bit.
+template <typename Precision>
+void FoliationDisk<Precision>::AdvanceOrbits(OrbitBatch& Batch) const{
+    typedef typename CirclePoint::Coordinate Coordinate;
+    const int Size = Batch.Size();
+    circle_coordinate_type* Points = Batch.m_Points.data();
+    int* IntervalIndices = Batch.m_IntervalIndices.data();
+    const char* Antipodal = Batch.m_Antipodal.data();
+    char* IsDivPoint = Batch.m_IsDivPoint.data();
+    const circle_coordinate_type Half = Coordinate::Half();
+    
+    for (int k = 0; k < Size; k++) {
+        Points[k] = Antipodal[k] ? Coordinate::Reduce(Points[k] + Half) :
+                                   Coordinate::Reduce(Coordinate::Reduce(-Points[k]) + m_TempForFollowTheLeaf[IntervalIndices[k]]);
+    }
+    
+    // The index of the Interval is the number of division points (apart from the first one) that are smaller than the point.
+    if (m_NumSeparatrices < EYTZINGER_SEARCH_THRESHOLD) {
+        for (int k = 0; k < Size; k++) {
+            IntervalIndices[k] = 0;
+        }
+        for (int i = 1; i < m_NumSeparatrices; i++) {
+            const circle_coordinate_type DivPoint = m_DivPointCoordinates[i];
+            for (int k = 0; k < Size; k++) {
+                IntervalIndices[k] += DivPoint < Points[k];
+            }
+        }
+    } else {
+        for (int k = 0; k < Size; k++) {
+            IntervalIndices[k] = 1;
+        }
+        for (int Level = 0; Level < m_EytzingerDepth; Level++) {
+            for (int k = 0; k < Size; k++) {
+                IntervalIndices[k] = 2 * IntervalIndices[k] + (m_EytzingerDivPoints[IntervalIndices[k]] < Points[k]);
+            }
+        }
+        for (int k = 0; k < Size; k++) {
+            IntervalIndices[k] -= 1 << m_EytzingerDepth;
+        }
+    }
+    
+    for (int k = 0; k < Size; k++) {
+        IsDivPoint[k] = (m_DivPointCoordinates[IntervalIndices[k]] == Points[k]) | (m_DivPointCoordinates[IntervalIndices[k] + 1] == Points[k]);
+    }
 }
 
 
@@ -156,9 +269,18 @@ int FoliationDisk::WhichIntervalContainsNew(const CirclePoint& t){
 
 // Find the index of the Interval that contains t
 // If t is a division point and is therefore contained in two Intervals, it returns the index of the first one.
-int FoliationDisk::WhichIntervalContains(const CirclePoint& t){
+template <typename Precision>
+int FoliationDisk<Precision>::WhichIntervalContains(const CirclePoint& t) const{
+    return m_NumSeparatrices < EYTZINGER_SEARCH_THRESHOLD ? WhichIntervalContains_ForFewSeparatrices(t) :
+                                                             WhichIntervalContains_ForManySeparatrices(t);
+}
+
+
+
+template <typename Precision>
+int FoliationDisk<Precision>::WhichIntervalContains_ForFewSeparatrices(const CirclePoint& t) const{
     int i = 0;
-    while (i < m_NumSeparatrices - 1 && m_DivPoints[i + 1].GetValue() < t.GetValue()) {
+    while (i < m_NumSeparatrices - 1 && m_DivPoints[i + 1].GetCoordinate() < t.GetCoordinate()) {
         i++;
     }
     return i;
@@ -166,32 +288,52 @@ int FoliationDisk::WhichIntervalContains(const CirclePoint& t){
 
 
 
-int FoliationDisk::WhichIntervalContains_ForManySeparatrices(const CirclePoint& t){  // broken!!
-    int begin = 0, end = m_NumSeparatrices, temp;
-    while (end - begin > 1) {   
-        temp = (begin + end) / 2;
-        m_DivPoints[temp].GetValue() > t.GetValue() ? end = temp : begin = temp;
+template <typename Precision>
+int FoliationDisk<Precision>::WhichIntervalContains_ForManySeparatrices(const CirclePoint& t) const{
+    // Since the tree is complete, the index of the leaf we end up at is the number of division points
+    // (apart from the first one) that are smaller than t, which is exactly the index of the Interval.
+    int TreeIndex = 1;
+    for (int Level = 0; Level < m_EytzingerDepth; Level++) {
+        TreeIndex = 2 * TreeIndex + (m_EytzingerDivPoints[TreeIndex] < t.GetCoordinate());
     }
-    return begin;
+    return TreeIndex - (1 << m_EytzingerDepth);
 } // Efficient for larger n's
 
 
 
+template <typename Precision>
+int FoliationDisk<Precision>::WhichIntervalContainsStrictly(const CirclePoint& t) const{
+    int Index = WhichIntervalContains(t);
+    if (m_DivPoints[Index].GetCoordinate() == t.GetCoordinate() || m_DivPoints[IncreaseIndex(Index)].GetCoordinate() == t.GetCoordinate()) {
+        throw ExceptionThePointIsADivPoint();
+    }
+    return Index;
+}
+
+
 
 
 // Decides if a point is a division point
-bool FoliationDisk::IsDivPoint(const CirclePoint& t){
-    for (int i = 0; i < m_NumSeparatrices; i++) {
-        if (m_DivPoints[i].GetValue() == t.GetValue()) {
-            return true;
-        }
-    }
-    return false;
+template <typename Precision>
+bool FoliationDisk<Precision>::IsDivPoint(const CirclePoint& t) const{
+    return Locate(t).m_IsDivPoint;
 }
 
 
 
-void FoliationDisk::Rotate(){
+// The distance of Step.m_Point from the nearest division point. The nearest ones are the endpoints of the Interval
+// containing it, so this is as cheap as Locate.
+template <typename Precision>
+typename Precision::real_type FoliationDisk<Precision>::DistanceFromDivPoints(const LeafStep& Step) const{
+    floating_point_type FromLeft = DistanceBetween(m_DivPoints[Step.m_IntervalIndex], Step.m_Point);
+    floating_point_type FromRight = DistanceBetween(Step.m_Point, m_DivPoints[IncreaseIndex(Step.m_IntervalIndex)]);
+    return FromLeft < FromRight ? FromLeft : FromRight;
+}
+
+
+
+template <typename Precision>
+void FoliationDisk<Precision>::Rotate(){
     FoliationDisk fd = *this;
     
     for (int i = 1; i < m_NumSeparatrices; i++) {
@@ -204,7 +346,8 @@ void FoliationDisk::Rotate(){
 }
 
 
-void FoliationDisk::Reflect(){
+template <typename Precision>
+void FoliationDisk<Precision>::Reflect(){
     FoliationDisk fd = *this;
 
     for (int i = 0; i < m_NumSeparatrices; i++) {
@@ -216,12 +359,121 @@ void FoliationDisk::Reflect(){
 
 
 
-int FoliationDisk::SeparatrixIndexOfPair(int SeparatrixIndex, LeftOrRight Side){
+// The starting index of the lexicographically least rotation of Sequence, by Booth's algorithm in linear time.
+template <typename T>
+int LeastRotation(const std::vector<T>& Sequence){
+    int n = static_cast<int>(Sequence.size());
+    std::vector<int> Failure(2 * n, -1);
+    int k = 0;
+    for (int j = 1; j < 2 * n; j++) {
+        const T& Current = Sequence[j % n];
+        int i = Failure[j - k - 1];
+        while (i != -1 && !(Current == Sequence[(k + i + 1) % n])) {
+            if (Current < Sequence[(k + i + 1) % n]) {
+                k = j - i - 1;
+            }
+            i = Failure[i];
+        }
+        if (!(Current == Sequence[(k + i + 1) % n])) {
+            if (Current < Sequence[k % n]) {
+                k = j;
+            }
+            Failure[j - k] = -1;
+        } else {
+            Failure[j - k] = i + 1;
+        }
+    }
+    return k % n;
+}
+
+
+// The smallest p > 0 such that rotating Sequence by p gives the same sequence. It is a divisor of the size.
+template <typename T>
+int SmallestPeriod(const std::vector<T>& Sequence){
+    int n = static_cast<int>(Sequence.size());
+    std::vector<int> Border(n, 0);
+    for (int j = 1; j < n; j++) {
+        int i = Border[j - 1];
+        while (i > 0 && !(Sequence[j] == Sequence[i])) {
+            i = Border[i - 1];
+        }
+        Border[j] = Sequence[j] == Sequence[i] ? i + 1 : 0;
+    }
+    int Period = n - (n > 0 ? Border[n - 1] : 0);
+    return n % Period == 0 ? Period : n;
+}
+
+
+// Rotate shifts the offsets of the pairs and the lengths the same way. Reflect reverses both and negates the offsets.
+template <typename Precision>
+std::vector<int> FoliationDisk<Precision>::GetPairOffsets() const{
+    std::vector<int> Offsets(m_NumSeparatrices);
+    for (int i = 0; i < m_NumSeparatrices; i++) {
+        Offsets[i] = m_Pair[i] >= i ? m_Pair[i] - i : m_Pair[i] - i + m_NumSeparatrices;
+    }
+    return Offsets;
+}
+
+
+template <typename T>
+std::vector<T> ReflectSequence(const std::vector<T>& Sequence){
+    return std::vector<T>(Sequence.rbegin(), Sequence.rend());
+}
+
+
+inline std::vector<int> ReflectPairOffsets(const std::vector<int>& Offsets){
+    int n = static_cast<int>(Offsets.size());
+    std::vector<int> Reflected(n);
+    for (int i = 0; i < n; i++) {
+        Reflected[i] = Offsets[n - 1 - i] == 0 ? 0 : n - Offsets[n - 1 - i];
+    }
+    return Reflected;
+}
+
+
+// Reading off the offsets of the pairs and the rounded lengths from each starting Interval, in both orientations, the
+// canonical form is the lexicographically least of these 2n sequences. Two foliations are rotations or reflections of
+// each other (with lengths rounded the same way) if and only if their canonical forms are equal. Takes O(n) time.
+template <typename Precision>
+typename FoliationDisk<Precision>::CanonicalForm FoliationDisk<Precision>::GetCanonicalForm(floating_point_type Quantum) const{
+    std::vector<int> Offsets = GetPairOffsets();
+    CanonicalForm Sequence(m_NumSeparatrices);
+    for (int i = 0; i < m_NumSeparatrices; i++) {
+        Sequence[i].first = Offsets[i];
+        Sequence[i].second = static_cast<long long>(std::floor(static_cast<double>(m_Lengths[i] / Quantum) + 0.5));
+    }
+    CanonicalForm Reflected = ReflectSequence(Sequence);
+    std::vector<int> ReflectedOffsets = ReflectPairOffsets(Offsets);
+    for (int i = 0; i < m_NumSeparatrices; i++) {
+        Reflected[i].first = ReflectedOffsets[i];
+    }
+    
+    std::rotate(Sequence.begin(), Sequence.begin() + LeastRotation(Sequence), Sequence.end());
+    std::rotate(Reflected.begin(), Reflected.begin() + LeastRotation(Reflected), Reflected.end());
+    return Reflected < Sequence ? Reflected : Sequence;
+}
+
+
+template <typename Precision>
+std::size_t FoliationDisk<Precision>::GetFingerprint(floating_point_type Quantum) const{
+    CanonicalForm Form = GetCanonicalForm(Quantum);
+    std::size_t Hash = Form.size();
+    for (int i = 0; i < Form.size(); i++) {
+        Hash ^= std::hash<long long>()(Form[i].second * m_NumSeparatrices + Form[i].first) + 0x9e3779b9 + (Hash << 6) + (Hash >> 2);
+    }
+    return Hash;
+}
+
+
+
+template <typename Precision>
+int FoliationDisk<Precision>::SeparatrixIndexOfPair(int SeparatrixIndex, LeftOrRight Side) const{
     return Side == RIGHT ? IncreaseIndex(m_Pair[SeparatrixIndex]) : m_Pair[DecreaseIndex(SeparatrixIndex)] ;
 }
 
 
-void FoliationDisk::CountSingularities(std::vector<int>& SingularityType, int BeginInterval, int EndInterval, bool FirstCall){
+template <typename Precision>
+void FoliationDisk<Precision>::CountSingularities(std::vector<int>& SingularityType, int BeginInterval, int EndInterval, bool FirstCall){
     int iterator = BeginInterval;
     int count = FirstCall ? 0 : 1;
     
@@ -238,7 +490,8 @@ void FoliationDisk::CountSingularities(std::vector<int>& SingularityType, int Be
 
 
 
-void FoliationDisk::GetSingularityType(std::vector<int>& SingularityType){
+template <typename Precision>
+void FoliationDisk<Precision>::GetSingularityType(std::vector<int>& SingularityType){
     SingularityType.clear();
     CountSingularities(SingularityType, 0, m_NumSeparatrices - 1, true);
     std::sort(SingularityType.begin(), SingularityType.end());
@@ -251,7 +504,8 @@ void FoliationDisk::GetSingularityType(std::vector<int>& SingularityType){
 
 
 
-bool ArePairsEqual(const FoliationDisk& fd1, const FoliationDisk& fd2)
+template <typename Precision>
+bool ArePairsEqual(const FoliationDisk<Precision>& fd1, const FoliationDisk<Precision>& fd2)
 {
     if (fd1.m_NumSeparatrices != fd2.m_NumSeparatrices) {
         return false;
@@ -265,13 +519,14 @@ bool ArePairsEqual(const FoliationDisk& fd1, const FoliationDisk& fd2)
 }
 
 
-bool AreLengthsEqual(const FoliationDisk& fd1, const FoliationDisk& fd2, floating_point_type AllowedError)
+template <typename Precision>
+bool AreLengthsEqual(const FoliationDisk<Precision>& fd1, const FoliationDisk<Precision>& fd2, typename Precision::real_type AllowedError)
 {
     if (fd1.m_NumSeparatrices != fd2.m_NumSeparatrices) {
         return false;
     }
     for (int i = 0; i < fd1.m_NumSeparatrices; i++) {
-        if (fabs(fd1.m_Lengths[i] - fd2.m_Lengths[i]) > AllowedError) {
+        if (Abs(fd1.m_Lengths[i] - fd2.m_Lengths[i]) > AllowedError) {
             return false;
         }
     }
@@ -280,42 +535,80 @@ bool AreLengthsEqual(const FoliationDisk& fd1, const FoliationDisk& fd2, floatin
 
 
 
-bool AreEqual(const FoliationDisk& fd1, const FoliationDisk& fd2, floating_point_type AllowedError){
+template <typename Precision>
+bool AreEqual(const FoliationDisk<Precision>& fd1, const FoliationDisk<Precision>& fd2, typename Precision::real_type AllowedError){
     return  ArePairsEqual(fd1, fd2) && AreLengthsEqual(fd1, fd2, AllowedError);
 }
 
 
 
-bool AreEqualUpToRotation(const FoliationDisk& fd1, const FoliationDisk& fd2, floating_point_type AllowedError){
-    if (fd1.m_NumSeparatrices != fd2.m_NumSeparatrices) {
-        return false;
+// Decides if there is an r such that Offsets1[i] == Offsets2[i - r] and Lengths1[i] and Lengths2[i - r] differ by at
+// most AllowedError for all i (indices taken mod n), i.e. whether rotating the second foliation r times gives the first.
+// The offsets match only for the r's taking the least rotation of Offsets2 to that of Offsets1, and these differ by
+// the multiples of the period, so no foliation has to be copied and rotated.
+template <typename Real>
+bool AreRotationsOfEachOther(const std::vector<int>& Offsets1, const std::vector<Real>& Lengths1,
+                             const std::vector<int>& Offsets2, const std::vector<Real>& Lengths2, Real AllowedError){
+    int n = static_cast<int>(Offsets1.size());
+    int Begin1 = LeastRotation(Offsets1);
+    int Begin2 = LeastRotation(Offsets2);
+    for (int j = 0; j < n; j++) {
+        if (Offsets1[(Begin1 + j) % n] != Offsets2[(Begin2 + j) % n]) {
+            return false;
+        }
     }
-    FoliationDisk fd = fd2;
-    for (int i = 0; i < fd1.m_NumSeparatrices; i++) {
-        if (ArePairsEqual(fd1, fd) && AreLengthsEqual(fd1, fd, AllowedError)) {
+    int Period = SmallestPeriod(Offsets1);
+    for (int r = (Begin1 - Begin2 + n) % n, Count = 0; Count < n / Period; r = (r + Period) % n, Count++) {
+        int i = 0;
+        while (i < n && !(Abs(Lengths1[i] - Lengths2[(i - r + n) % n]) > AllowedError)) {
+            i++;
+        }
+        if (i == n) {
             return true;
         }
-        fd.Rotate();
-       // std::cout << fd;
     }
     return false;
 }
 
 
 
-bool AreEqualUpToRotationAndReflection(const FoliationDisk& fd1, const FoliationDisk& fd2, floating_point_type AllowedError){
+template <typename Precision>
+bool ArePairsEqualUpToRotationAndReflection(const FoliationDisk<Precision>& fd1, const FoliationDisk<Precision>& fd2){
     if (fd1.m_NumSeparatrices != fd2.m_NumSeparatrices) {
         return false;
     }
-    FoliationDisk fd = fd2;
-    if (AreEqualUpToRotation(fd1, fd, AllowedError)) {
-        return true;
+    std::vector<int> Offsets1 = fd1.GetPairOffsets();
+    std::vector<int> Offsets2 = fd2.GetPairOffsets();
+    std::vector<int> Reflected2 = ReflectPairOffsets(Offsets2);
+    std::rotate(Offsets1.begin(), Offsets1.begin() + LeastRotation(Offsets1), Offsets1.end());
+    std::rotate(Offsets2.begin(), Offsets2.begin() + LeastRotation(Offsets2), Offsets2.end());
+    std::rotate(Reflected2.begin(), Reflected2.begin() + LeastRotation(Reflected2), Reflected2.end());
+    return Offsets1 == Offsets2 || Offsets1 == Reflected2;
+}
+
+
+
+template <typename Precision>
+bool AreEqualUpToRotation(const FoliationDisk<Precision>& fd1, const FoliationDisk<Precision>& fd2, typename Precision::real_type AllowedError){
+    if (fd1.m_NumSeparatrices != fd2.m_NumSeparatrices) {
+        return false;
     }
-    fd.Reflect();
-    if (AreEqualUpToRotation(fd1, fd, AllowedError)) {
+    return AreRotationsOfEachOther(fd1.GetPairOffsets(), fd1.m_Lengths, fd2.GetPairOffsets(), fd2.m_Lengths, AllowedError);
+}
+
+
+
+template <typename Precision>
+bool AreEqualUpToRotationAndReflection(const FoliationDisk<Precision>& fd1, const FoliationDisk<Precision>& fd2, typename Precision::real_type AllowedError){
+    if (fd1.m_NumSeparatrices != fd2.m_NumSeparatrices) {
+        return false;
+    }
+    std::vector<int> Offsets1 = fd1.GetPairOffsets();
+    std::vector<int> Offsets2 = fd2.GetPairOffsets();
+    if (AreRotationsOfEachOther(Offsets1, fd1.m_Lengths, Offsets2, fd2.m_Lengths, AllowedError)) {
         return true;
     }
-    return false;
+    return AreRotationsOfEachOther(Offsets1, fd1.m_Lengths, ReflectPairOffsets(Offsets2), ReflectSequence(fd2.m_Lengths), AllowedError);
 }
 
 
@@ -325,7 +618,8 @@ bool AreEqualUpToRotationAndReflection(const FoliationDisk& fd1, const Foliation
 
 
 
-std::ostream& operator<<(std::ostream& Out, FoliationDisk fd){
+template <typename Precision>
+std::ostream& operator<<(std::ostream& Out, FoliationDisk<Precision> fd){
     using namespace std;
 
     Out << "Lengths: ";
@@ -348,3 +642,16 @@ std::ostream& operator<<(std::ostream& Out, FoliationDisk fd){
 
 
 
+
+
+#define INSTANTIATE_FOLIATION_DISK(Precision) \
+    template class FoliationDisk<Precision>; \
+    template bool ArePairsEqual(const FoliationDisk<Precision>&, const FoliationDisk<Precision>&); \
+    template bool AreLengthsEqual(const FoliationDisk<Precision>&, const FoliationDisk<Precision>&, Precision::real_type); \
+    template bool ArePairsEqualUpToRotationAndReflection(const FoliationDisk<Precision>&, const FoliationDisk<Precision>&); \
+    template bool AreEqual(const FoliationDisk<Precision>&, const FoliationDisk<Precision>&, Precision::real_type); \
+    template bool AreEqualUpToRotation(const FoliationDisk<Precision>&, const FoliationDisk<Precision>&, Precision::real_type); \
+    template bool AreEqualUpToRotationAndReflection(const FoliationDisk<Precision>&, const FoliationDisk<Precision>&, Precision::real_type); \
+    template std::ostream& operator<<(std::ostream&, FoliationDisk<Precision>);
+
+FOR_EACH_PRECISION(INSTANTIATE_FOLIATION_DISK)
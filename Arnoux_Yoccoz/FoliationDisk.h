@@ -40,26 +40,64 @@
 #include "WeighedTree.h"
 
 const floating_point_type PRECISION = 0.000000001;
+const int EYTZINGER_SEARCH_THRESHOLD = 20; // from this many separatrices on, Intervals are looked up in the Eytzinger layout
 
 class ExceptionThePointIsADivPoint {};
 
 
+template <typename Precision = DefaultPrecision>
 class FoliationDisk
 {
 public:
+    typedef typename Precision::real_type floating_point_type;
+    typedef typename Precision::coordinate_type circle_coordinate_type;
+    typedef ::CirclePoint<Precision> CirclePoint;
+    
+    // One intersection of a leaf with the boundary circle, together with everything Lengthen needs to know about it
+    struct LeafStep{
+        CirclePoint m_Point;        // the intersection point
+        int m_IntervalIndex;        // the index of the Interval containing m_Point, as returned by WhichIntervalContains
+        bool m_IsDivPoint;          // true if m_Point is a division point, i.e. the leaf has run into a singularity
+    };
+    
+    // The endpoints of several leaves, stored lane by lane (instead of as LeafSteps), so that AdvanceOrbits can
+    // compute the next intersection of all of them together with the same few operations.
+    struct OrbitBatch{
+        std::vector<circle_coordinate_type> m_Points;
+        std::vector<int> m_IntervalIndices;     // the index of the Interval containing m_Points[k]
+        std::vector<char> m_Antipodal;          // true if the next intersection of the k'th leaf is the antipodal point
+        std::vector<char> m_IsDivPoint;         // set by AdvanceOrbits if m_Points[k] is a division point
+        
+        int Size() const{ return static_cast<int>(m_Points.size()); }
+        void Resize(int Size){ m_Points.resize(Size); m_IntervalIndices.resize(Size); m_Antipodal.resize(Size); m_IsDivPoint.resize(Size); }
+    };
+    
+    // The pairing and the lengths (rounded to a multiple of some quantum) read off from a starting Interval
+    typedef std::vector<std::pair<int, long long> > CanonicalForm;
+    
     FoliationDisk(const WeighedTree& wt);
     FoliationDisk(const std::vector<floating_point_type>& Lengths, const std::vector<int>& Pair);
   //  FoliationDisk(const FoliationDisk& fd);
-    CirclePoint FollowTheLeaf(const CirclePoint& t); // The point we get by following the leaf from t until we hit the boundary circle again.
-    int WhichIntervalContainsNew(const CirclePoint& t);
-    int WhichIntervalContains(const CirclePoint& t);      // Find the index of the Interval that contains t
-    int WhichIntervalContains_ForManySeparatrices(const CirclePoint& t); // another version of the previous function, faster for many separatrices
-    bool IsDivPoint(const CirclePoint& t); // Decides if a point is a division point
+    CirclePoint FollowTheLeaf(const CirclePoint& t) const; // The point we get by following the leaf from t until we hit the boundary circle again.
+    LeafStep Locate(const CirclePoint& t) const; // Finds the Interval containing t and decides if t is a division point with a single lookup
+    LeafStep NextIntersection(const CirclePoint& t, int IntervalIndex, bool Antipodal) const; // One step of a leaf, see the .cpp file
+    void AdvanceOrbits(OrbitBatch& Batch) const; // NextIntersection for every lane of Batch at once
+    int WhichIntervalContains(const CirclePoint& t) const;      // Find the index of the Interval that contains t
+    int WhichIntervalContains_ForFewSeparatrices(const CirclePoint& t) const; // linear scan, faster for few separatrices
+    int WhichIntervalContains_ForManySeparatrices(const CirclePoint& t) const; // branchless search, faster for many separatrices
+    int WhichIntervalContainsStrictly(const CirclePoint& t) const; // same as WhichIntervalContains, but throws if t is a division point
+    bool IsDivPoint(const CirclePoint& t) const; // Decides if a point is a division point
+    floating_point_type DistanceFromDivPoints(const LeafStep& Step) const; // The distance of Step.m_Point from the nearest division point
     void Rotate();
     void Reflect();
+    int GetNumSeparatrices() const{ return m_NumSeparatrices; }
     int GetPair(int Index) const{ return m_Pair[Index]; }
+    floating_point_type GetLength(int Index) const{ return m_Lengths[Index]; }   // after averaging and normalizing
+    const CirclePoint& GetDivPoint(int Index) const{ return m_DivPoints[Index]; }
+    CanonicalForm GetCanonicalForm(floating_point_type Quantum) const; // the same for rotations and reflections of the foliation, see the .cpp file
+    std::size_t GetFingerprint(floating_point_type Quantum) const; // a hash of GetCanonicalForm
     
-    friend std::ostream& operator<<(std::ostream& Out, FoliationDisk fd);
+    template <typename P> friend std::ostream& operator<<(std::ostream& Out, FoliationDisk<P> fd);
     
     
 protected:
@@ -70,12 +108,14 @@ protected:
     inline int IncreaseIndex(int SeparatrixIndex) const{ return SeparatrixIndex < m_NumSeparatrices - 1 ? SeparatrixIndex + 1 : 0; }
     inline int DecreaseIndex(int SeparatrixIndex) const{ return SeparatrixIndex > 0 ? SeparatrixIndex - 1 : m_NumSeparatrices - 1; }
     inline int ReflectIndex(int SeparatrixIndex) const{ return m_NumSeparatrices - 1 - SeparatrixIndex; }
-    int SeparatrixIndexOfPair(int SeparatrixIndex, LeftOrRight Side);
+    int SeparatrixIndexOfPair(int SeparatrixIndex, LeftOrRight Side) const;
 
 private:
     std::vector<floating_point_type> m_Lengths;  // lengths of the Intervals between division points
-    std::vector<floating_point_type> m_TempForFollowTheLeaf; // storing some often used data for fast calculation
-    std::vector<floating_point_type> m_ShiftedDivPoints; // the points DivPoints[i] +/- PRECISION
+    std::vector<circle_coordinate_type> m_TempForFollowTheLeaf; // storing some often used data for fast calculation
+    std::vector<circle_coordinate_type> m_DivPointCoordinates; // the coordinates of m_DivPoints, then that of m_DivPoints[0] again
+    std::vector<circle_coordinate_type> m_EytzingerDivPoints; // m_DivPoints[1], ..., m_DivPoints[m_NumSeparatrices - 1] in Eytzinger order
+    int m_EytzingerDepth; // the number of levels of the complete binary tree stored in m_EytzingerDivPoints
 
     void Allocate();
     void Init(); // Initializes variables once everything is allocated and m_NumSeparatrices, m_Lengths and m_Pair are defined
@@ -85,13 +125,16 @@ private:
     void FillInLengthsAndPair(int StartingIndex, WeighedTree::Node* pNode);
     void CountSingularities(std::vector<int>& SingularityType, int BeginInterval, int EndInterval, bool FirstCall);
     void GetSingularityType(std::vector<int>& SingularityType);
-    int FindBetweenShiftedDivPoints(const CirclePoint& t, int StartIndex, int EndIndex);
+    void InitEytzingerDivPoints();
+    std::vector<int> GetPairOffsets() const; // (m_Pair[i] - i) mod m_NumSeparatrices, only shifted cyclically by Rotate
+    int FillEytzingerDivPoints(const std::vector<circle_coordinate_type>& SortedValues, int SortedIndex, int TreeIndex);
 
-    friend bool ArePairsEqual(const FoliationDisk& fd1, const FoliationDisk& fd2);
-    friend bool AreLengthsEqual(const FoliationDisk& fd1, const FoliationDisk& fd2, floating_point_type AllowedError);
-    friend bool AreEqual(const FoliationDisk& fd1, const FoliationDisk& fd2, floating_point_type AllowedError);
-    friend bool AreEqualUpToRotation(const FoliationDisk& fd1, const FoliationDisk& fd2, floating_point_type AllowedError);
-    friend bool AreEqualUpToRotationAndReflection(const FoliationDisk& fd1, const FoliationDisk& fd2, floating_point_type AllowedError);
+    template <typename P> friend bool ArePairsEqual(const FoliationDisk<P>& fd1, const FoliationDisk<P>& fd2);
+    template <typename P> friend bool AreLengthsEqual(const FoliationDisk<P>& fd1, const FoliationDisk<P>& fd2, typename P::real_type AllowedError);
+    template <typename P> friend bool ArePairsEqualUpToRotationAndReflection(const FoliationDisk<P>& fd1, const FoliationDisk<P>& fd2);
+    template <typename P> friend bool AreEqual(const FoliationDisk<P>& fd1, const FoliationDisk<P>& fd2, typename P::real_type AllowedError);
+    template <typename P> friend bool AreEqualUpToRotation(const FoliationDisk<P>& fd1, const FoliationDisk<P>& fd2, typename P::real_type AllowedError);
+    template <typename P> friend bool AreEqualUpToRotationAndReflection(const FoliationDisk<P>& fd1, const FoliationDisk<P>& fd2, typename P::real_type AllowedError);
 };
 
 
@@ -0,0 +1,170 @@
+/*******************************************************************************
+ *  CLASS NAME:	FoliationFamily
+ *  AUTHOR:		Balazs Strenner
+ *				Copyright 2013 UW-Madison. All rights reserved.
+ *
+ ******************************************************************************/
+
+
+#include "FoliationFamily.h"
+
+
+
+
+// Each member is built as a FoliationDisk first, so the lengths are averaged and normalized the same way, and then
+// its division points and FollowTheLeaf data are copied into the rows.
+template <typename Precision>
+FoliationFamily<Precision>::FoliationFamily(const std::vector<std::vector<floating_point_type>>& LengthVectors, const std::vector<int>& Pair) :
+    m_NumMembers(static_cast<int>(LengthVectors.size())),
+    m_NumSeparatrices(static_cast<int>(Pair.size())),
+    m_LengthVectors(LengthVectors),
+    m_Pair(Pair),
+    m_DivPointCoordinates((Pair.size() + 1) * LengthVectors.size()),
+    m_TempForFollowTheLeaf(Pair.size() * LengthVectors.size())
+{
+    for (int k = 0; k < m_NumMembers; k++) {
+        FoliationDisk fd(LengthVectors[k], Pair);
+        for (int i = 0; i <= m_NumSeparatrices; i++) {
+            m_DivPointCoordinates[i * m_NumMembers + k] = fd.GetDivPoint(i < m_NumSeparatrices ? i : 0).GetCoordinate();
+        }
+        for (int i = 0; i < m_NumSeparatrices; i++) {
+            m_TempForFollowTheLeaf[i * m_NumMembers + k] = fd.GetDivPoint(Pair[i]).GetCoordinate() +
+                                                           fd.GetDivPoint(i < m_NumSeparatrices - 1 ? i + 1 : 0).GetCoordinate();
+        }
+    }
+}
+
+
+
+
+// The same as FoliationDisk::AdvanceOrbits, with the k'th lane in the k'th member, so Batch must have one lane for
+// each member. The Interval is found by a branchless binary search over the rows, which takes the same number of
+// rounds in every lane.
+template <typename Precision>
+void FoliationFamily<Precision>::AdvanceOrbits(OrbitBatch& Batch) const{
+    typedef typename CirclePoint<Precision>::Coordinate Coordinate;
+    circle_coordinate_type* Points = Batch.m_Points.data();
+    int* IntervalIndices = Batch.m_IntervalIndices.data();
+    const char* Antipodal = Batch.m_Antipodal.data();
+    char* IsDivPoint = Batch.m_IsDivPoint.data();
+    const circle_coordinate_type Half = Coordinate::Half();
+    const circle_coordinate_type* Temp = m_TempForFollowTheLeaf.data();
+    const circle_coordinate_type* DivPoints = m_DivPointCoordinates.data();
+
+    for (int k = 0; k < m_NumMembers; k++) {
+        Points[k] = Antipodal[k] ? Coordinate::Reduce(Points[k] + Half) :
+                                   Coordinate::Reduce(Coordinate::Reduce(-Points[k]) + Temp[IntervalIndices[k] * m_NumMembers + k]);
+    }
+
+    // The index of the Interval is the number of division points (apart from the first one) that are smaller than the
+    // point. The search keeps it between IntervalIndices[k] and IntervalIndices[k] + Length.
+    for (int k = 0; k < m_NumMembers; k++) {
+        IntervalIndices[k] = 0;
+    }
+    for (int Length = m_NumSeparatrices - 1; Length > 1; Length -= Length / 2) {
+        const int Step = Length / 2;
+        for (int k = 0; k < m_NumMembers; k++) {
+            IntervalIndices[k] += (DivPoints[(IntervalIndices[k] + Step + 1) * m_NumMembers + k] < Points[k]) * Step;
+        }
+    }
+    for (int k = 0; k < m_NumMembers; k++) {
+        IntervalIndices[k] += DivPoints[(IntervalIndices[k] + 1) * m_NumMembers + k] < Points[k];
+    }
+
+    for (int k = 0; k < m_NumMembers; k++) {
+        IsDivPoint[k] = (DivPoints[IntervalIndices[k] * m_NumMembers + k] == Points[k]) |
+                        (DivPoints[(IntervalIndices[k] + 1) * m_NumMembers + k] == Points[k]);
+    }
+}
+
+
+
+
+// Follows the separatrix from the given division point in every member, as in FoliationRP2::GetItinerary: the first
+// intersection after the division point has depth 2.
+template <typename Precision>
+std::vector<int> FoliationFamily<Precision>::GetDivergenceDepths(int SeparatrixIndex, int MaxDepth) const{
+    std::vector<int> DivergenceDepths(m_NumMembers, MaxDepth + 1);
+    OrbitBatch Batch;
+    Batch.Resize(m_NumMembers);
+    for (int k = 0; k < m_NumMembers; k++) {
+        Batch.m_Points[k] = DivPointCoordinate(SeparatrixIndex, k);
+        Batch.m_IntervalIndices[k] = SeparatrixIndex > 0 ? SeparatrixIndex - 1 : 0;    // as returned by Locate
+    }
+
+    int NumDiverged = 1;    // the first member is not compared to itself
+    for (int Depth = 2; Depth <= MaxDepth && NumDiverged < m_NumMembers; Depth++) {
+        for (int k = 0; k < m_NumMembers; k++) {
+            Batch.m_Antipodal[k] = Depth % 2 == 0;
+        }
+        AdvanceOrbits(Batch);
+        for (int k = 1; k < m_NumMembers; k++) {
+            if (DivergenceDepths[k] > MaxDepth && (Batch.m_IntervalIndices[k] != Batch.m_IntervalIndices[0] ||
+                                                   Batch.m_IsDivPoint[k] != Batch.m_IsDivPoint[0])) {
+                DivergenceDepths[k] = Depth;
+                NumDiverged++;
+            }
+        }
+        if (Batch.m_IsDivPoint[0]) {
+            // a saddle connection of the first member, the members that have not diverged have it too
+            break;
+        }
+    }
+    return DivergenceDepths;
+}
+
+
+
+
+
+// Follows the separatrix in every lane with AdvanceOrbits, and at the same time in a FoliationDisk built separately
+// from the lengths of the member with NextIntersection, until it runs into a division point. False if a lane ever
+// gets a different point (compared exactly), Interval or division point flag than its FoliationDisk.
+template <typename Precision>
+bool FoliationFamily<Precision>::AgreesWithFoliationDisks(int SeparatrixIndex, int MaxDepth) const{
+    std::vector<FoliationDisk> Disks;
+    std::vector<LeafStep> Steps;
+    OrbitBatch Batch;
+    Batch.Resize(m_NumMembers);
+    for (int k = 0; k < m_NumMembers; k++) {
+        Disks.push_back(FoliationDisk(m_LengthVectors[k], m_Pair));
+        Steps.push_back(Disks[k].Locate(Disks[k].GetDivPoint(SeparatrixIndex)));
+        Batch.m_Points[k] = DivPointCoordinate(SeparatrixIndex, k);
+        Batch.m_IntervalIndices[k] = SeparatrixIndex > 0 ? SeparatrixIndex - 1 : 0;
+    }
+
+    std::vector<char> Finished(m_NumMembers, false);    // the separatrix of the member has run into a division point
+    int NumFinished = 0;
+    for (int Depth = 2; Depth <= MaxDepth && NumFinished < m_NumMembers; Depth++) {
+        for (int k = 0; k < m_NumMembers; k++) {
+            Batch.m_Antipodal[k] = Depth % 2 == 0;
+        }
+        AdvanceOrbits(Batch);
+        for (int k = 0; k < m_NumMembers; k++) {
+            if (Finished[k]) {
+                continue;
+            }
+            Steps[k] = Disks[k].NextIntersection(Steps[k].m_Point, Steps[k].m_IntervalIndex, Depth % 2 == 0);
+            if (!(Steps[k].m_Point.GetCoordinate() == Batch.m_Points[k]) ||
+                Steps[k].m_IntervalIndex != Batch.m_IntervalIndices[k] ||
+                Steps[k].m_IsDivPoint != static_cast<bool>(Batch.m_IsDivPoint[k])) {
+                return false;
+            }
+            if (Steps[k].m_IsDivPoint) {
+                Finished[k] = true;
+                NumFinished++;
+            }
+        }
+    }
+    return true;
+}
+
+
+
+
+
+
+#define INSTANTIATE_FOLIATION_FAMILY(Precision) \
+    template class FoliationFamily<Precision>;
+
+FOR_EACH_PRECISION(INSTANTIATE_FOLIATION_FAMILY)
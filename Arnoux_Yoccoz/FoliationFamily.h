@@ -0,0 +1,64 @@
+/*******************************************************************************
+ *  CLASS NAME:	FoliationFamily
+ *  AUTHOR:		Balazs Strenner
+ *				Copyright 2013 UW-Madison. All rights reserved.
+ *
+ *	DESCRIPTION: Measured foliations on RP^2 with the same pairing (m_Pair) but different lengths, for example the points
+                of a grid in the space of lengths, followed together.
+
+    LAYOUT:     The foliations are the members of the family. The division points and the data of FollowTheLeaf are
+                stored row by row, one row for each division point, and in a row the members come one after the other.
+                So the k'th lane of an OrbitBatch can follow a leaf of the k'th member, and going through the lanes
+                reads the rows in order, which the compiler can do in vector instructions.
+
+    ITINERARIES: Starting from the same division point, the separatrices of the members hit the Intervals with the
+                same indices until the lengths make a difference. GetDivergenceDepths finds the first depth where the
+                separatrix of a member goes through a different Interval than that of the first member, or runs into a
+                division point when the other one does not. Up to that depth everything computed from the Intervals
+                alone (e.g. the IntervalIntersectionCount of the separatrix segments) is the same for the two members.
+
+                The steps are done in the same order as in FoliationDisk, so each lane agrees with NextIntersection of
+                the corresponding FoliationDisk bit for bit (AgreesWithFoliationDisks checks this). Rounding errors
+                are not taken into account.
+ *
+ *
+ ******************************************************************************/
+
+#ifndef ArnouxYoccoz_FoliationFamily_h
+#define ArnouxYoccoz_FoliationFamily_h
+
+#include <vector>
+#include "FoliationDisk.h"
+
+
+
+template <typename Precision = DefaultPrecision>
+class FoliationFamily{
+public:
+    typedef typename Precision::real_type floating_point_type;
+    typedef typename Precision::coordinate_type circle_coordinate_type;
+    typedef ::FoliationDisk<Precision> FoliationDisk;
+    typedef typename FoliationDisk::OrbitBatch OrbitBatch;
+    typedef typename FoliationDisk::LeafStep LeafStep;
+
+    FoliationFamily(const std::vector<std::vector<floating_point_type>>& LengthVectors, const std::vector<int>& Pair);
+
+    int GetNumMembers() const{ return m_NumMembers; }
+    int GetNumSeparatrices() const{ return m_NumSeparatrices; }
+    void AdvanceOrbits(OrbitBatch& Batch) const;     // the k'th lane takes a step in the k'th member, see the .cpp file
+    std::vector<int> GetDivergenceDepths(int SeparatrixIndex, int MaxDepth) const;  // MaxDepth + 1 for the members not diverging until MaxDepth
+    bool AgreesWithFoliationDisks(int SeparatrixIndex, int MaxDepth) const;  // compares every lane with a FoliationDisk of the member
+
+private:
+    int m_NumMembers;
+    int m_NumSeparatrices;
+    std::vector<std::vector<floating_point_type>> m_LengthVectors;  // the lengths of the members, as given to the constructor
+    std::vector<int> m_Pair;
+    std::vector<circle_coordinate_type> m_DivPointCoordinates;   // row i is the i'th division point, row m_NumSeparatrices is the 0'th again
+    std::vector<circle_coordinate_type> m_TempForFollowTheLeaf;  // row i is the same as m_TempForFollowTheLeaf[i] in FoliationDisk
+
+    const circle_coordinate_type& DivPointCoordinate(int Index, int Member) const{ return m_DivPointCoordinates[Index * m_NumMembers + Member]; }
+};
+
+
+#endif
@@ -11,6 +11,12 @@
 
 
 #include "FoliationRP2.h"
+#include "FoliationFamily.h"
+#include <climits>
+#include <sstream>
+#include <typeinfo>
+#include <functional>
+#include <iterator>
 
 
 
@@ -23,9 +29,12 @@
 /**************************************************************************************************************/
 
 
-FoliationRP2::SeparatrixSegment::SeparatrixSegment(const std::vector<CirclePoint>& DivPoints) :
-    m_IntervalIntersectionCount(DivPoints.size(), 0),
+template <typename Precision>
+FoliationRP2<Precision>::SeparatrixSegment::SeparatrixSegment(const std::vector<CirclePoint>& DivPoints) :
+    m_IntervalIntersectionCount(static_cast<int>(DivPoints.size()), 0),
     m_Depth(1),
+    m_EndpointIntervalIndex(0),
+    m_ErrorBound(0),
     m_ArcsAroundDivPoints(DivPoints),
     m_Side(CENTER)
 {
@@ -36,7 +45,8 @@ FoliationRP2::SeparatrixSegment::SeparatrixSegment(const std::vector<CirclePoint
 
 
 
-LeftOrRight FoliationRP2::SeparatrixSegment::BeginShiftWhenEndpointShiftedTo(LeftOrRight Side) const{
+template <typename Precision>
+LeftOrRight FoliationRP2<Precision>::SeparatrixSegment::BeginShiftWhenEndpointShiftedTo(LeftOrRight Side) const{
     return (!ReversesOrientationQ() && Side == RIGHT) || (ReversesOrientationQ() && Side == LEFT) ? RIGHT : LEFT;
 }
 
@@ -44,15 +54,16 @@ LeftOrRight FoliationRP2::SeparatrixSegment::BeginShiftWhenEndpointShiftedTo(Lef
 
 
 
-void FoliationRP2::ShiftToSide(SeparatrixSegment& s, LeftOrRight Side){
+template <typename Precision>
+void FoliationRP2<Precision>::ShiftToSide(SeparatrixSegment& s, LeftOrRight Side){
     assert(s.m_Side == CENTER);
     assert(Side != CENTER);
     
     s.m_Side = Side;
     s.m_Endpoint.Shift(s.EndpointShiftWhenBeginShiftedTo(Side));
-    s.m_IntervalIntersectionCount[s.m_Side == LEFT ? DecreaseIndex(s.m_Separatrix) : s.m_Separatrix]++;
+    s.m_IntervalIntersectionCount.Modify(s.m_Side == LEFT ? DecreaseIndex(s.m_Separatrix) : s.m_Separatrix)++;
     if (s.EndsOnFrontSideQ() && s.m_Depth > 1) {
-        s.m_IntervalIntersectionCount[WhichIntervalContains(s.m_Endpoint)]++;
+        s.m_IntervalIntersectionCount.Modify(s.m_EndpointIntervalIndex)++;
     }
     if (s.m_Depth > 1) {
         s.m_ArcsAroundDivPoints.InsertPoint(m_DivPoints[s.m_Separatrix].ShiftedTo(Side));
@@ -64,7 +75,8 @@ void FoliationRP2::ShiftToSide(SeparatrixSegment& s, LeftOrRight Side){
 
 
 
-std::ostream& operator<<(std::ostream& Out, const FoliationRP2::SeparatrixSegment& s)
+template <typename Precision>
+std::ostream& FoliationRP2<Precision>::Print(std::ostream& Out, const SeparatrixSegment& s)
 {    
     Out << "Separatrix Index: " << s.m_Separatrix << std::endl;
     Out << "Depth: " << s.m_Depth << std::endl;
@@ -85,7 +97,7 @@ std::ostream& operator<<(std::ostream& Out, const FoliationRP2::SeparatrixSegmen
     Out << std::endl;
     Out << "ArcsAroundDivpoints:\n" << s.m_ArcsAroundDivPoints;
     Out << "IntervalIntersectionCount: ";
-    for (int i = 0; i < s.m_IntervalIntersectionCount.size(); i++) {
+    for (int i = 0; i < s.m_IntervalIntersectionCount.Size(); i++) {
         Out << s.m_IntervalIntersectionCount[i] << " ";
     }
     Out << std::endl;
@@ -106,14 +118,20 @@ std::ostream& operator<<(std::ostream& Out, const FoliationRP2::SeparatrixSegmen
 
 
 
-void FoliationRP2::AddToGoodSegmentsIfGood(const SeparatrixSegment& s){
+template <typename Precision>
+void FoliationRP2<Precision>::AddToGoodSegmentsIfGood(const SeparatrixSegment& s){
     if (s.m_ArcsAroundDivPoints.ContainsQ(s.m_Endpoint)){
         for (LeftOrRight Side = LEFT; Side < 2; Side++) {
-            m_GoodShiftedSeparatrixSegments[s.m_Separatrix][Side].push_back(s);
-            std::list<SeparatrixSegment>::reverse_iterator it = m_GoodShiftedSeparatrixSegments[s.m_Separatrix][Side].rbegin();
-            ShiftToSide(*it, Side);
-            if (!it->m_ArcsAroundDivPoints.ContainsQ(it->m_Endpoint))
-                m_GoodShiftedSeparatrixSegments[s.m_Separatrix][Side].pop_back();
+            AppendOnlyStore<SeparatrixSegment>& Segments = m_GoodShiftedSeparatrixSegments[s.m_Separatrix][Side];
+            Segments.PushBack(s);
+            ShiftToSide(Segments.Back(), Side);
+            if (!Segments.Back().m_ArcsAroundDivPoints.ContainsQ(Segments.Back().m_Endpoint)) {
+                Segments.PopBack();
+                continue;
+            }
+            if (COUNT_CHECKPOINT_SPACING > 0)
+                Segments.Back().m_IntervalIntersectionCount = SharedVector<int>();   // rebuilt from the checkpoints
+            m_GoodEndpointIndices[s.m_Separatrix][Side].Insert(Segments.Back().m_Endpoint.GetCoordinate(), Segments.Size() - 1);
         }
     }
 }
@@ -123,61 +141,413 @@ void FoliationRP2::AddToGoodSegmentsIfGood(const SeparatrixSegment& s){
 
 
 
-void FoliationRP2::Lengthen(SeparatrixSegment& s){
+template <typename Precision>
+void FoliationRP2<Precision>::Lengthen(SeparatrixSegment& s){
+    Lengthen(s, NextIntersection(s.m_Endpoint, s.m_EndpointIntervalIndex, s.EndsOnFrontSideQ()));
+}
+
+
+
+
+// Step must be the next intersection of the separatrix after the endpoint of s.
+template <typename Precision>
+void FoliationRP2<Precision>::Lengthen(SeparatrixSegment& s, const LeafStep& Step){
     if (s.m_Depth > 1) {
-        s.m_IntervalIntersectionCount[WhichIntervalContains(s.m_Endpoint)]++;
+        s.m_IntervalIntersectionCount.Modify(s.m_EndpointIntervalIndex)++;
         s.m_ArcsAroundDivPoints.InsertPoint(s.m_Endpoint); // inserting the new intersection point to m_ArcsAroundDivPoints
     }
-    s.m_Endpoint = s.EndsOnFrontSideQ() ? s.m_Endpoint.Antipodal() : FollowTheLeaf(s.m_Endpoint);
-    s.m_Depth++;
+    MoveEndpoint(s, Step, 1);
+}
+
+
+
+
+// Lengthens s up to the next time it returns to the domain of one of its induced maps, but not beyond MaxDepth.
+// The intersections in between are not near the division points, so they are only counted. If no induced map
+// can be used, s is lengthened by one step.
+template <typename Precision>
+void FoliationRP2<Precision>::Advance(SeparatrixSegment& s, int MaxDepth){
+    UpdateInducedMaps(s);
+    const std::vector<InducedMap>& Maps = m_InducedMaps[s.m_Separatrix];
+    if (COUNT_CHECKPOINT_SPACING > 0 && (m_CountCheckpoints[s.m_Separatrix].back().m_MaxDepth != MaxDepth ||
+                                         m_CountCheckpoints[s.m_Separatrix].back().m_NumInducedMaps != Maps.size())) {
+        SaveCountCheckpoint(s, MaxDepth);
+    }
+    int Level;
+    const typename InducedMap::Piece* p = FindReturn(s.m_Separatrix, static_cast<int>(Maps.size()), s.m_Endpoint, s.EndsOnFrontSideQ(),
+                                                     MaxDepth - s.m_Depth, s.m_ErrorBound, Level);
+    if (p != NULL) {
+        for (int i = 0; i < m_NumSeparatrices; i++) {
+            s.m_IntervalIntersectionCount.Modify(i) += p->m_IntervalIntersectionCount[i];
+        }
+        s.m_ArcsAroundDivPoints.InsertPoint(s.m_Endpoint);
+        MoveEndpoint(s, Locate(CirclePoint::FromReducedCoordinate(Maps[Level].Apply(*p, s.m_Endpoint.GetCoordinate()))), p->m_ReturnTime);
+        return;
+    }
+    Lengthen(s);
+}
+
+
+
+
+// The piece of the finest of the first NumMaps induced maps of the separatrix whose return from Endpoint takes at most
+// MaxSteps steps, if Endpoint is far enough from the boundary of the piece to be sure it is in it. Level is set to the
+// index of that map. NULL if there is no such piece.
+template <typename Precision>
+const typename FoliationRP2<Precision>::InducedMap::Piece* FoliationRP2<Precision>::FindReturn(int SeparatrixIndex, int NumMaps,
+                                                                                              const CirclePoint& Endpoint, bool FrontSide,
+                                                                                              int MaxSteps, floating_point_type ErrorBound,
+                                                                                              int& Level) const{
+    const std::vector<InducedMap>& Maps = m_InducedMaps[SeparatrixIndex];
+    const circle_coordinate_type& x = Endpoint.GetCoordinate();
+    for (Level = NumMaps - 1; Level >= 0; Level--) {
+        const typename InducedMap::Piece* p = Maps[Level].FindPiece(x, FrontSide);
+        if (p != NULL && p->m_ReturnTime <= MaxSteps &&
+            Maps[Level].DistanceFromBoundary(*p, x) > ErrorBound + m_DivPointError + p->m_ReturnTime * m_StepError) {
+            return p;
+        }
+    }
+    return NULL;
+}
+
+
+
+
+// The second half of lengthening: the endpoint of s is moved NumSteps steps forward to Step, and the new segment
+// is checked.
+template <typename Precision>
+void FoliationRP2<Precision>::MoveEndpoint(SeparatrixSegment& s, const LeafStep& Step, int NumSteps){
+    s.m_Endpoint = Step.m_Point;
+    s.m_EndpointIntervalIndex = Step.m_IntervalIndex;
+    s.m_Depth += NumSteps;
+    s.m_ErrorBound += NumSteps * m_StepError;
     
-    // Checking if the new endpoint is a division point in which case we reached a saddle connection
-    if (IsDivPoint(s.m_Endpoint)) {
-        m_FoundSaddleConnectionQ[s.m_Separatrix] = 1;
-    } else {
-        AddToGoodSegmentsIfGood(s);
+    // Checking if the new endpoint is a division point in which case we reached a saddle connection.
+    // If it is only too close to a division point to tell, the endpoint is recomputed in higher precision.
+    bool Recomputed = false;
+    if (Step.m_IsDivPoint || (CAN_ESCALATE && DistanceFromDivPoints(Step) <= s.m_ErrorBound + m_DivPointError)) {
+        if (!CAN_ESCALATE || !RecomputePrecisely(s)) {
+            m_FoundSaddleConnectionQ[s.m_Separatrix] = 1;
+            return;
+        }
+        Recomputed = true;
+    }
+    if (COUNT_CHECKPOINT_SPACING > 0 &&
+        (Recomputed || s.m_Depth / COUNT_CHECKPOINT_SPACING != (s.m_Depth - NumSteps) / COUNT_CHECKPOINT_SPACING)) {
+        SaveCountCheckpoint(s, m_CountCheckpoints[s.m_Separatrix].back().m_MaxDepth);
     }
+    AddToGoodSegmentsIfGood(s);
 }
 
 
 
 
+// Records the current segment s of its separatrix, to be advanced towards MaxDepth from here on. A checkpoint of the
+// same depth is replaced.
+template <typename Precision>
+void FoliationRP2<Precision>::SaveCountCheckpoint(const SeparatrixSegment& s, int MaxDepth){
+    std::vector<CountCheckpoint>& Checkpoints = m_CountCheckpoints[s.m_Separatrix];
+    if (Checkpoints.empty() || Checkpoints.back().m_Depth < s.m_Depth) {
+        Checkpoints.push_back(CountCheckpoint());
+    }
+    CountCheckpoint& c = Checkpoints.back();
+    c.m_Depth = s.m_Depth;
+    c.m_Endpoint = s.m_Endpoint;
+    c.m_EndpointIntervalIndex = s.m_EndpointIntervalIndex;
+    c.m_ErrorBound = s.m_ErrorBound;
+    c.m_IntervalIntersectionCount = s.m_IntervalIntersectionCount.ToVector();
+    c.m_NumInducedMaps = static_cast<int>(m_InducedMaps[s.m_Separatrix].size());
+    c.m_MaxDepth = MaxDepth;
+}
 
 
 
 
+// The m_IntervalIntersectionCount of s, which is not kept if s is a stored good segment. Then the separatrix is
+// followed from the last checkpoint before s the same way as Advance did, and the intersections added by ShiftToSide
+// are counted at the end.
+template <typename Precision>
+std::vector<int> FoliationRP2<Precision>::GetIntervalIntersectionCount(const SeparatrixSegment& s){
+    if (s.m_IntervalIntersectionCount.Size() > 0) {
+        return s.m_IntervalIntersectionCount.ToVector();
+    }
+    const std::vector<CountCheckpoint>& Checkpoints = m_CountCheckpoints[s.m_Separatrix];
+    int Index = static_cast<int>(Checkpoints.size()) - 1;
+    while (Checkpoints[Index].m_Depth > s.m_Depth) {
+        Index--;
+    }
+    CountCheckpoint c = Checkpoints[Index];
+    std::vector<int>& Count = c.m_IntervalIntersectionCount;
+    
+    while (c.m_Depth < s.m_Depth) {
+        bool FrontSide = c.m_Depth % 2 == 1;
+        int Level;
+        const typename InducedMap::Piece* p = FindReturn(s.m_Separatrix, c.m_NumInducedMaps, c.m_Endpoint, FrontSide,
+                                                         c.m_MaxDepth - c.m_Depth, c.m_ErrorBound, Level);
+        LeafStep Step;
+        int NumSteps;
+        if (p != NULL) {
+            for (int i = 0; i < m_NumSeparatrices; i++) {
+                Count[i] += p->m_IntervalIntersectionCount[i];
+            }
+            Step = Locate(CirclePoint::FromReducedCoordinate(m_InducedMaps[s.m_Separatrix][Level].Apply(*p, c.m_Endpoint.GetCoordinate())));
+            NumSteps = p->m_ReturnTime;
+        } else {
+            if (c.m_Depth > 1) {
+                Count[c.m_EndpointIntervalIndex]++;
+            }
+            Step = NextIntersection(c.m_Endpoint, c.m_EndpointIntervalIndex, FrontSide);
+            NumSteps = 1;
+        }
+        c.m_Endpoint = Step.m_Point;
+        c.m_EndpointIntervalIndex = Step.m_IntervalIndex;
+        c.m_Depth += NumSteps;
+        c.m_ErrorBound += NumSteps * m_StepError;
+    }
+    assert(c.m_Depth == s.m_Depth && c.m_EndpointIntervalIndex == s.m_EndpointIntervalIndex);
+    
+    if (s.m_Side != CENTER) {
+        Count[s.m_Side == LEFT ? DecreaseIndex(s.m_Separatrix) : s.m_Separatrix]++;
+        if (s.EndsOnFrontSideQ() && s.m_Depth > 1) {
+            Count[s.m_EndpointIntervalIndex]++;
+        }
+    }
+    return Count;
+}
+
+
 
 
+// Builds a new induced map for the separatrix of s if its arcs around the division points have shrunk enough, or s has
+// grown enough, since the last one. If the map can't be built, the old ones are still good, and it is tried again
+// later.
+template <typename Precision>
+void FoliationRP2<Precision>::UpdateInducedMaps(const SeparatrixSegment& s){
+    if (s.m_Depth < INDUCTION_MIN_DEPTH) {
+        return;
+    }
+    floating_point_type Measure = s.m_ArcsAroundDivPoints.GetMeasure();
+    if (Measure > m_NextInductionMeasure[s.m_Separatrix] && s.m_Depth < m_NextInductionDepth[s.m_Separatrix]) {
+        return;
+    }
+    m_NextInductionDepth[s.m_Separatrix] = s.m_Depth > INT_MAX / INDUCTION_REFINEMENT_RATIO ? INT_MAX : s.m_Depth * INDUCTION_REFINEMENT_RATIO;
+    std::vector<InducedMap>& Maps = m_InducedMaps[s.m_Separatrix];
+    try {
+        Maps.push_back(InducedMap(Maps.empty() ? m_StepMap : Maps.back(), s.m_ArcsAroundDivPoints.GetArcs()));
+        m_NextInductionMeasure[s.m_Separatrix] = Maps.back().GetMeasure() / INDUCTION_REFINEMENT_RATIO;
+    } catch (const ExceptionInductionFailed&) {
+        m_NextInductionMeasure[s.m_Separatrix] = Measure / INDUCTION_REFINEMENT_RATIO;
+    }
+}
 
 
 
 
 
-FoliationRP2::SeparatrixSegment& FoliationRP2::GetGoodSeparatrixSegment(int SeparatrixIndex, int Depth, LeftOrRight Side){
-    if (m_CurrentSepSegments[SeparatrixIndex].m_Depth >= Depth) {
-        for (std::list<SeparatrixSegment>::iterator it = m_GoodShiftedSeparatrixSegments[SeparatrixIndex][Side].begin();
-             it != m_GoodShiftedSeparatrixSegments[SeparatrixIndex][Side].end(); it++) {
-            if(it->m_Depth == Depth)
-                return *it;
+// Follows the separatrix of s in m_PreciseFoliation up to the depth of s, and replaces the endpoint of s by the
+// rounded precise endpoint. Returns false if the separatrix can't be followed that far, i.e. it is within rounding
+// error of a division point even in m_PreciseFoliation, or the precise endpoint is not distinguishable from a division
+// point after rounding.
+template <typename Precision>
+bool FoliationRP2<Precision>::RecomputePrecisely(SeparatrixSegment& s){
+    PreciseOrbit& Orbit = m_PreciseOrbits[s.m_Separatrix];
+    std::vector<const PreciseInducedMap*> Maps;
+    std::vector<precise_floating_point_type> Radius;
+    RefinePreciseInducedMaps(s.m_Depth - Orbit.m_Depth, Maps, Radius);
+    while (Orbit.m_Depth < s.m_Depth) {
+        if (!AdvancePrecisely(Orbit, s.m_Depth, Maps, Radius)) {
+            return false;
+        }
+    }
+    
+    LeafStep Step = Locate(CirclePoint(static_cast<floating_point_type>(Orbit.m_Endpoint.GetValue())));
+    if (Step.m_IsDivPoint || Step.m_IntervalIndex != Orbit.m_EndpointIntervalIndex) {
+        return false;
+    }
+    s.m_Endpoint = Step.m_Point;
+    s.m_EndpointIntervalIndex = Step.m_IntervalIndex;
+    s.m_ErrorBound = static_cast<floating_point_type>(Orbit.m_ErrorBound) + CirclePoint::Coordinate::template RoundingError<floating_point_type>();
+    return true;
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+// The itinerary of a separatrix: the letter of the intersection at depth k is 2 * (Interval index) + 1 on the front side
+// and 2 * (Interval index) on the back side. The itinerary is cut short before the first intersection that can't be
+// told apart from a division point.
+template <typename Precision>
+std::vector<int> FoliationRP2<Precision>::GetItinerary(int SeparatrixIndex, int Length){
+    std::vector<int> Itinerary;
+    LeafStep Step = Locate(m_DivPoints[SeparatrixIndex]);
+    for (int Depth = 2; Itinerary.size() < Length; Depth++) {
+        Step = NextIntersection(Step.m_Point, Step.m_IntervalIndex, Depth % 2 == 0);
+        if (Step.m_IsDivPoint || DistanceFromDivPoints(Step) <= m_DivPointError + Depth * m_StepError) {
+            break;
         }
-        throw ExceptionNoObjectFound();
+        Itinerary.push_back(2 * Step.m_IntervalIndex + Depth % 2);
+    }
+    return Itinerary;
+}
+
+
+
+
+// The IntervalIntersectionCount of the segment of the given depth, from the substitution of the itinerary of its
+// separatrix.
+template <typename Precision>
+std::vector<long long> FoliationRP2<Precision>::GetIntervalIntersectionCount(const Substitution& ItinerarySubstitution, long long Depth){
+    std::vector<long long> LetterCount = ItinerarySubstitution.CountLetters(Depth - 2);
+    std::vector<long long> Count(m_NumSeparatrices);
+    for (int i = 0; i < m_NumSeparatrices; i++) {
+        Count[i] = LetterCount[2 * i] + LetterCount[2 * i + 1];
+    }
+    return Count;
+}
+
+
+
+
+
+// Moves Orbit to its next return to one of the neighbourhoods of Maps (of the given Radius), without going beyond
+// MaxDepth, or one step if that is not possible. Returns false if the new endpoint is within rounding error of a
+// division point.
+template <typename Precision>
+bool FoliationRP2<Precision>::AdvancePrecisely(PreciseOrbit& Orbit, int MaxDepth, const std::vector<const PreciseInducedMap*>& Maps,
+                                               const std::vector<precise_floating_point_type>& Radius){
+    typedef typename PreciseInducedMap::Piece Piece;
+    typename PreciseFoliationDisk::LeafStep Step;
+    const typename PreciseFoliationDisk::circle_coordinate_type& x = Orbit.m_Endpoint.GetCoordinate();
+    int NumSteps = 0;
+    for (int Level = static_cast<int>(Maps.size()) - 1; Level >= 0 && NumSteps == 0; Level--) {
+        const Piece* p = Maps[Level]->FindPiece(x, Orbit.m_Depth % 2 == 1);
+        if (p != NULL && p->m_ReturnTime <= MaxDepth - Orbit.m_Depth) {
+            precise_floating_point_type Error = Orbit.m_ErrorBound + p->m_ReturnTime * m_PreciseStepError;
+            if (Maps[Level]->DistanceFromBoundary(*p, x) > Error && Radius[Level] > Error) {
+                Step = m_PreciseFoliation.Locate(PreciseCirclePoint::FromReducedCoordinate(Maps[Level]->Apply(*p, x)));
+                NumSteps = p->m_ReturnTime;
+            }
+        }
+    }
+    if (NumSteps == 0) {
+        Step = m_PreciseFoliation.NextIntersection(Orbit.m_Endpoint, Orbit.m_EndpointIntervalIndex, Orbit.m_Depth % 2 == 1);
+        NumSteps = 1;
+    }
+    Orbit.m_Endpoint = Step.m_Point;
+    Orbit.m_EndpointIntervalIndex = Step.m_IntervalIndex;
+    Orbit.m_Depth += NumSteps;
+    Orbit.m_ErrorBound += NumSteps * m_PreciseStepError;
+    return !Step.m_IsDivPoint && m_PreciseFoliation.DistanceFromDivPoints(Step) > Orbit.m_ErrorBound + m_PreciseDivPointError;
+}
+
+
+
+
+// Builds first return maps of m_PreciseFoliation to neighbourhoods of the division points, halving the radius each
+// time, until an orbit of NumSteps steps is expected to return to the smallest one only a few times. Maps and Radius are
+// set to the maps up to the first such one, or all of them if no more can be built. The maps that are there already are
+// not changed and the deque does not move them, so Maps stays valid while other threads add more.
+template <typename Precision>
+void FoliationRP2<Precision>::RefinePreciseInducedMaps(int NumSteps, std::vector<const PreciseInducedMap*>& Maps,
+                                                       std::vector<precise_floating_point_type>& Radius){
+    std::lock_guard<std::mutex> Lock(m_PreciseInductionMutex);
+    while (!m_PreciseInductionFailed &&
+           (m_PreciseInducedMaps.empty() ? m_PreciseStepMap : m_PreciseInducedMaps.back()).GetMeasure() * NumSteps > m_NumSeparatrices) {
+        precise_floating_point_type NewRadius = m_PreciseInductionRadius.empty() ? precise_floating_point_type(1) / (4 * m_NumSeparatrices) :
+                                                                                    m_PreciseInductionRadius.back() / 2;
+        std::vector<PreciseArc> Domain;
+        for (int i = 0; i < m_NumSeparatrices; i++) {
+            precise_floating_point_type DivPoint = m_PreciseFoliation.GetDivPoint(i).GetValue();
+            Domain.push_back(PreciseArc(PreciseCirclePoint(DivPoint - NewRadius), PreciseCirclePoint(DivPoint + NewRadius)));
+        }
+        try {
+            m_PreciseInducedMaps.push_back(PreciseInducedMap(m_PreciseInducedMaps.empty() ? m_PreciseStepMap : m_PreciseInducedMaps.back(), Domain));
+            m_PreciseInductionRadius.push_back(NewRadius);
+        } catch (const ExceptionInductionFailed&) {
+            m_PreciseInductionFailed = true;
+        }
+    }
+    
+    Maps.clear();
+    Radius.clear();
+    for (int Level = 0; Level < m_PreciseInducedMaps.size() &&
+                        (Level == 0 ? m_PreciseStepMap : m_PreciseInducedMaps[Level - 1]).GetMeasure() * NumSteps > m_NumSeparatrices; Level++) {
+        Maps.push_back(&m_PreciseInducedMaps[Level]);
+        Radius.push_back(m_PreciseInductionRadius[Level]);
+    }
+}
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+
+// The segment of the separatrix of the given depth shifted to Side, NULL if it is not good. Most segments are not, so
+// this is an ordinary outcome and not an error.
+template <typename Precision>
+typename FoliationRP2<Precision>::SeparatrixSegment* FoliationRP2<Precision>::GetGoodSeparatrixSegment(int SeparatrixIndex, int Depth, LeftOrRight Side){
+    AppendOnlyStore<SeparatrixSegment>& Segments = m_GoodShiftedSeparatrixSegments[SeparatrixIndex][Side];
+    if (m_CurrentSepSegments[SeparatrixIndex].m_Depth >= Depth) {
+        int Index = FindDepth(Segments, Depth);
+        if (Index < Segments.Size() && Segments[Index].m_Depth == Depth)
+            return &Segments[Index];
+        return NULL;
     } else {
         while (m_CurrentSepSegments[SeparatrixIndex].m_Depth < Depth) {
-            Lengthen(m_CurrentSepSegments[SeparatrixIndex]);
+            Advance(m_CurrentSepSegments[SeparatrixIndex], Depth);
         }
-        if (m_GoodShiftedSeparatrixSegments[SeparatrixIndex][Side].back().m_Depth == Depth) {
-            return m_GoodShiftedSeparatrixSegments[SeparatrixIndex][Side].back();
+        if (Segments.Back().m_Depth == Depth) {
+            return &Segments.Back();
         } else
-            throw ExceptionNoObjectFound();
+            return NULL;
     }
 }
 
 
 
 
-FoliationRP2::SeparatrixSegment& FoliationRP2::GetGoodSeparatrixSegment(SeparatrixSegment& s, LeftOrRight EndpointShiftedTo){
+template <typename Precision>
+int FoliationRP2<Precision>::FindDepth(const AppendOnlyStore<SeparatrixSegment>& Segments, int Depth){
+    int Begin = 0;
+    int End = Segments.Size();
+    while (Begin < End) {
+        int Middle = Begin + (End - Begin) / 2;
+        if (Segments[Middle].m_Depth < Depth) {
+            Begin = Middle + 1;
+        } else {
+            End = Middle;
+        }
+    }
+    return Begin;
+}
+
+
+
+
+template <typename Precision>
+typename FoliationRP2<Precision>::SeparatrixSegment* FoliationRP2<Precision>::GetGoodSeparatrixSegment(SeparatrixSegment& s, LeftOrRight EndpointShiftedTo){
     if (s.EndpointShiftWhenBeginShiftedTo(s.m_Side) == EndpointShiftedTo) {
-        return s;
+        return &s;
     }
     return GetGoodSeparatrixSegment(s.m_Separatrix, s.m_Depth, Opposite(s.m_Side));
 }
@@ -188,21 +558,43 @@ FoliationRP2::SeparatrixSegment& FoliationRP2::GetGoodSeparatrixSegment(Separatr
 
 
 
-FoliationRP2::SeparatrixSegment& FoliationRP2::GetFirstIntersection(int SeparatrixIndex, const Arc& arc, const LeftOrRight ReturnSide){
-    for(std::list<SeparatrixSegment>::iterator it = m_GoodShiftedSeparatrixSegments[SeparatrixIndex][ReturnSide].begin();
-        it != m_GoodShiftedSeparatrixSegments[SeparatrixIndex][ReturnSide].end(); it++){
-        if (arc.ContainsQ(it->m_Endpoint.Centered())) {
-            return *it;
-        }
+// The centered endpoints on arc are the keys from Left to Right, where Left and Right are excluded if they are shifted
+// away from the arc. If arc goes through 0, they are the keys from Left on and the keys up to Right.
+template <typename Precision>
+int FoliationRP2<Precision>::FindFirstEndpointInArc(int SeparatrixIndex, LeftOrRight Side, const Arc& arc) const{
+    const RangeMinimumIndex<circle_coordinate_type>& Index = m_GoodEndpointIndices[SeparatrixIndex][Side];
+    if (arc.GetLength() == 1) {
+        return Index.GetMinimum(0, Index.Size());
+    }
+    const CirclePoint& Left = arc.GetLeftEndpoint();
+    const CirclePoint& Right = arc.GetRightEndpoint();
+    int First = Left.IsShiftedTo(RIGHT) ? Index.UpperBound(Left.GetCoordinate()) : Index.LowerBound(Left.GetCoordinate());
+    int Last = Right.IsShiftedTo(LEFT) ? Index.LowerBound(Right.GetCoordinate()) : Index.UpperBound(Right.GetCoordinate());
+    if (Right < Left) {
+        return std::min(Index.GetMinimum(First, Index.Size()), Index.GetMinimum(0, Last));
     }
-    while (!arc.ContainsQ(m_GoodShiftedSeparatrixSegments[SeparatrixIndex][ReturnSide].back().m_Endpoint.Centered())) {
-        Lengthen(m_CurrentSepSegments[SeparatrixIndex]);
-        if(m_FoundSaddleConnectionQ[SeparatrixIndex]){ // if any time along the way a saddle connection is found by FindNextSeparatrixSegment,
-            // the function is terminated and false is returned
-            throw ExceptionFoundSaddleConnection(); // SADDLE CONNECTION
+    return Index.GetMinimum(First, Last);
+}
+
+
+
+
+// The first good segment of the separatrix whose endpoint is on arc. If there is none yet, the separatrix is lengthened
+// until there is one. NULL if the separatrix reaches a saddle connection first.
+template <typename Precision>
+typename FoliationRP2<Precision>::SeparatrixSegment* FoliationRP2<Precision>::GetFirstIntersection(int SeparatrixIndex, const Arc& arc, const LeftOrRight ReturnSide){
+    AppendOnlyStore<SeparatrixSegment>& Segments = m_GoodShiftedSeparatrixSegments[SeparatrixIndex][ReturnSide];
+    int Index = FindFirstEndpointInArc(SeparatrixIndex, ReturnSide, arc);
+    if (Index < INT_MAX) {
+        return &Segments[Index];
+    }
+    while (!arc.ContainsQ(Segments.Back().m_Endpoint.Centered())) {
+        Advance(m_CurrentSepSegments[SeparatrixIndex], INT_MAX);
+        if(m_FoundSaddleConnectionQ[SeparatrixIndex]){ // SADDLE CONNECTION
+            return NULL;
         }
     }
-    return m_GoodShiftedSeparatrixSegments[SeparatrixIndex][ReturnSide].back();
+    return &Segments.Back();
 }
 
 
@@ -226,11 +618,12 @@ FoliationRP2::SeparatrixSegment& FoliationRP2::GetFirstIntersection(int Separatr
 
 
 
-void FoliationRP2::BigTransitionMatrix::UpdateTransitionMatrix(const SeparatrixSegment& s, int SmallIntervalIndex)
+template <typename Precision>
+void FoliationRP2<Precision>::BigTransitionMatrix::UpdateTransitionMatrix(const std::vector<int>& IntervalIntersectionCount, int SmallIntervalIndex)
 {
     std::vector<int> AmountOfChange(m_Size, 0);
     AmountOfChange[SmallIntervalIndex] = 1;
-    UpdateTransitionMatrix(s, AmountOfChange);
+    UpdateTransitionMatrix(IntervalIntersectionCount, AmountOfChange);
 }
 
 
@@ -239,10 +632,11 @@ void FoliationRP2::BigTransitionMatrix::UpdateTransitionMatrix(const SeparatrixS
 
 
 
-void FoliationRP2::BigTransitionMatrix::UpdateTransitionMatrix(const SeparatrixSegment& s, const std::vector<int>& AmountOfChange)
+template <typename Precision>
+void FoliationRP2<Precision>::BigTransitionMatrix::UpdateTransitionMatrix(const std::vector<int>& IntervalIntersectionCount, const std::vector<int>& AmountOfChange)
 {
     for (int LongIntervalIndex = 0; LongIntervalIndex < m_Size; LongIntervalIndex++) {
-        UpdateRow(LongIntervalIndex, AmountOfChange, s.m_IntervalIntersectionCount[LongIntervalIndex]);
+        UpdateRow(LongIntervalIndex, AmountOfChange, IntervalIntersectionCount[LongIntervalIndex]);
     }    
 }
 
@@ -251,7 +645,8 @@ void FoliationRP2::BigTransitionMatrix::UpdateTransitionMatrix(const SeparatrixS
 
 
 
-void FoliationRP2::BigTransitionMatrix::UpdateRow(int Row, const std::vector<int>& AmountOfChange, int HowManyTimes){
+template <typename Precision>
+void FoliationRP2<Precision>::BigTransitionMatrix::UpdateRow(int Row, const std::vector<int>& AmountOfChange, int HowManyTimes){
     for (int ShortIntervalIndex = 0; ShortIntervalIndex < m_Size; ShortIntervalIndex++) {
         m_Matrix[Row][ShortIntervalIndex] += AmountOfChange[ShortIntervalIndex] * HowManyTimes;
     }
@@ -262,7 +657,8 @@ void FoliationRP2::BigTransitionMatrix::UpdateRow(int Row, const std::vector<int
 
 
 
-void FoliationRP2::BigTransitionMatrix::Rotate(){
+template <typename Precision>
+void FoliationRP2<Precision>::BigTransitionMatrix::Rotate(){
     for (int i = 0; i < m_Matrix.size(); i++) {
         std::rotate(m_Matrix[i].begin(), m_Matrix[i].end() - 1, m_Matrix[i].end());
     }
@@ -273,7 +669,8 @@ void FoliationRP2::BigTransitionMatrix::Rotate(){
 
 
 
-void FoliationRP2::BigTransitionMatrix::Reflect(){
+template <typename Precision>
+void FoliationRP2<Precision>::BigTransitionMatrix::Reflect(){
     for (int i = 0; i < m_Matrix.size(); i++) {
         std::reverse(m_Matrix[i].begin(), m_Matrix[i].end());
     }
@@ -287,7 +684,8 @@ void FoliationRP2::BigTransitionMatrix::Reflect(){
 
 
 
-FoliationRP2::GoodOneSidedCurve::GoodOneSidedCurve(const SeparatrixSegment& SegmentShiftedToLeft,
+template <typename Precision>
+FoliationRP2<Precision>::GoodOneSidedCurve::GoodOneSidedCurve(const SeparatrixSegment& SegmentShiftedToLeft,
                                                    const SeparatrixSegment& SegmentShiftedToRight, const Arc& ConnectingArc) :
     m_SegmentShiftedToLeft(SegmentShiftedToLeft),
     m_SegmentShiftedToRight(SegmentShiftedToRight),
@@ -297,17 +695,6 @@ FoliationRP2::GoodOneSidedCurve::GoodOneSidedCurve(const SeparatrixSegment& Segm
 
 
 
-bool operator==(const FoliationRP2::GoodOneSidedCurve& c1, const FoliationRP2::GoodOneSidedCurve& c2){
-    return c1.m_SegmentShiftedToLeft.m_Separatrix == c2.m_SegmentShiftedToLeft.m_Separatrix &&
-    c1.m_SegmentShiftedToRight.m_Separatrix == c2.m_SegmentShiftedToRight.m_Separatrix &&
-    c1.m_SegmentShiftedToLeft.m_Depth == c2.m_SegmentShiftedToLeft.m_Depth &&
-    c1.m_SegmentShiftedToRight.m_Depth == c2.m_SegmentShiftedToRight.m_Depth;
-}
-
-
-
-
-
 /**************************************************************************************************************/
 /*                                                                                                            */
 /*                            FoliationRP2::GoodOneSidedCurve (RELATED FUNCTIONS)                             */
@@ -317,7 +704,10 @@ bool operator==(const FoliationRP2::GoodOneSidedCurve& c1, const FoliationRP2::G
 
 
 
-FoliationRP2::TransitionData FoliationRP2::CutAlongCurve(const GoodOneSidedCurve& GoodCurve){
+// NULL if a separatrix reaches a saddle connection before it crosses the curve, or a segment needed for the matrix is
+// not good, and Status tells which. The segments are looked up one by one, and the search stops at the first failure.
+template <typename Precision>
+std::unique_ptr<typename FoliationRP2<Precision>::TransitionData> FoliationRP2<Precision>::CutAlongCurve(const GoodOneSidedCurve& GoodCurve, CutStatus& Status){
     std::vector<CirclePoint> DivPointsUnordered(m_NumSeparatrices);
     std::vector<SeparatrixSegment*> Segment(m_NumSeparatrices);
     
@@ -325,7 +715,11 @@ FoliationRP2::TransitionData FoliationRP2::CutAlongCurve(const GoodOneSidedCurve
     floating_point_type NewCircumference = 2 * GoodCurve.m_ConnectingArc.GetLength();
     const CirclePoint& LeftEndpoint = GoodCurve.m_ConnectingArc.GetLeftEndpoint();
     for (int i = 0; i < m_NumSeparatrices; i++) {
-        Segment[i] = &GetFirstIntersection(i, GoodCurve.m_ConnectingArc, RIGHT);
+        Segment[i] = GetFirstIntersection(i, GoodCurve.m_ConnectingArc, RIGHT);
+        if (Segment[i] == NULL) {
+            Status = CUT_SADDLE_CONNECTION;
+            return std::unique_ptr<TransitionData>();
+        }
         if (Segment[i]->EndsOnFrontSideQ())
             DivPointsUnordered[i] = CirclePoint(DistanceBetween(LeftEndpoint, Segment[i]->m_Endpoint)/NewCircumference);
         else
@@ -350,7 +744,7 @@ FoliationRP2::TransitionData FoliationRP2::CutAlongCurve(const GoodOneSidedCurve
         
         SeparatrixIndexOfNewDivPoint[i] = static_cast<int>(std::find(DivPointsUnordered.begin(), DivPointsUnordered.begin() + m_NumSeparatrices, DivPoints[i]) - DivPointsUnordered.begin()) ;
 
-        if (DivPoints[i] < 0.5) {
+        if (DivPoints[i] < CirclePoint(0.5)) {
             LastDivPointBeforeHalf++;
         }
     }
@@ -376,10 +770,14 @@ FoliationRP2::TransitionData FoliationRP2::CutAlongCurve(const GoodOneSidedCurve
     
     for (int ShortIntervalIndex = 0; ShortIntervalIndex < m_NumSeparatrices; ShortIntervalIndex += 2) {
         if (ShortIntervalIndex != LastDivPointBeforeHalf && Pair[ShortIntervalIndex] != LastDivPointBeforeHalf) {
-            const SeparatrixSegment& s1 = GetGoodSeparatrixSegment(*Segment[SeparatrixIndexOfNewDivPoint[ShortIntervalIndex + 1]], LEFT);
-            const SeparatrixSegment& s2 = GetGoodSeparatrixSegment(*Segment[SeparatrixIndexOfNewDivPoint[Pair[ShortIntervalIndex]]], RIGHT);
-            Matrix.UpdateTransitionMatrix(s1, ShortIntervalIndex);
-            Matrix.UpdateTransitionMatrix(s2, ShortIntervalIndex);
+            const SeparatrixSegment* s1 = GetGoodSeparatrixSegment(*Segment[SeparatrixIndexOfNewDivPoint[ShortIntervalIndex + 1]], LEFT);
+            const SeparatrixSegment* s2 = s1 == NULL ? NULL : GetGoodSeparatrixSegment(*Segment[SeparatrixIndexOfNewDivPoint[Pair[ShortIntervalIndex]]], RIGHT);
+            if (s2 == NULL) {
+                Status = CUT_SEGMENT_NOT_GOOD;
+                return std::unique_ptr<TransitionData>();
+            }
+            Matrix.UpdateTransitionMatrix(GetIntervalIntersectionCount(*s1), ShortIntervalIndex);
+            Matrix.UpdateTransitionMatrix(GetIntervalIntersectionCount(*s2), ShortIntervalIndex);
             //PrintMatrix(Matrix);
         } else
         {
@@ -387,13 +785,25 @@ FoliationRP2::TransitionData FoliationRP2::CutAlongCurve(const GoodOneSidedCurve
             int GoodInterval = Pair[BadInterval];
             
             // SeparatrixSegment* LeftSegment_BadInterval = Segment[SeparatrixIndexOfNewDivPoint[BadInterval]];
-            const SeparatrixSegment& RightSegment_BadInterval = GetGoodSeparatrixSegment(*Segment[SeparatrixIndexOfNewDivPoint[BadInterval + 1]],LEFT);
-            const SeparatrixSegment& LeftSegment_GoodInterval = GetGoodSeparatrixSegment(*Segment[SeparatrixIndexOfNewDivPoint[GoodInterval]], RIGHT);
+            const SeparatrixSegment* RightSegment_BadInterval = GetGoodSeparatrixSegment(*Segment[SeparatrixIndexOfNewDivPoint[BadInterval + 1]],LEFT);
+            const SeparatrixSegment* LeftSegment_GoodInterval = RightSegment_BadInterval == NULL ? NULL : GetGoodSeparatrixSegment(*Segment[SeparatrixIndexOfNewDivPoint[GoodInterval]], RIGHT);
+            if (LeftSegment_GoodInterval == NULL) {
+                Status = CUT_SEGMENT_NOT_GOOD;
+                return std::unique_ptr<TransitionData>();
+            }
             
             Arc LengthenedArc(GoodCurve.m_ConnectingArc.GetLeftEndpoint(), GoodCurve.m_ConnectingArc.GetRightEndpoint().Centered());
-            const SeparatrixSegment& MiddleSegment_BadInterval = GetGoodSeparatrixSegment(GetFirstIntersection(m_Pair[DecreaseIndex(SeparatrixIndexOfNewDivPoint[0])] , LengthenedArc, LEFT), LEFT);
-            
-            const SeparatrixSegment& FirstSegment = GetGoodSeparatrixSegment(*Segment[SeparatrixIndexOfNewDivPoint[0]], LEFT);
+            SeparatrixSegment* MiddleIntersection = GetFirstIntersection(m_Pair[DecreaseIndex(SeparatrixIndexOfNewDivPoint[0])] , LengthenedArc, LEFT);
+            if (MiddleIntersection == NULL) {
+                Status = CUT_SADDLE_CONNECTION;
+                return std::unique_ptr<TransitionData>();
+            }
+            const SeparatrixSegment* MiddleSegment_BadInterval = GetGoodSeparatrixSegment(*MiddleIntersection, LEFT);
+            const SeparatrixSegment* FirstSegment = MiddleSegment_BadInterval == NULL ? NULL : GetGoodSeparatrixSegment(*Segment[SeparatrixIndexOfNewDivPoint[0]], LEFT);
+            if (FirstSegment == NULL) {
+                Status = CUT_SEGMENT_NOT_GOOD;
+                return std::unique_ptr<TransitionData>();
+            }
             
             std::vector<int> IncompleteIntervalContribution(m_NumSeparatrices, 0);
             
@@ -404,19 +814,19 @@ FoliationRP2::TransitionData FoliationRP2::CutAlongCurve(const GoodOneSidedCurve
                 IncompleteIntervalContribution[i]--;
             }
             
-            Matrix.UpdateTransitionMatrix(MiddleSegment_BadInterval, IncompleteIntervalContribution);
-            Matrix.UpdateTransitionMatrix(FirstSegment, IncompleteIntervalContribution);
+            Matrix.UpdateTransitionMatrix(GetIntervalIntersectionCount(*MiddleSegment_BadInterval), IncompleteIntervalContribution);
+            Matrix.UpdateTransitionMatrix(GetIntervalIntersectionCount(*FirstSegment), IncompleteIntervalContribution);
             
-            Matrix.UpdateTransitionMatrix(LeftSegment_GoodInterval, ShortIntervalIndex);
-            Matrix.UpdateTransitionMatrix(RightSegment_BadInterval, ShortIntervalIndex);
+            Matrix.UpdateTransitionMatrix(GetIntervalIntersectionCount(*LeftSegment_GoodInterval), ShortIntervalIndex);
+            Matrix.UpdateTransitionMatrix(GetIntervalIntersectionCount(*RightSegment_BadInterval), ShortIntervalIndex);
             //PrintMatrix(Matrix);
         }
     }
     
     
     
-    TransitionData td = { FoliationDisk(Lengths, Pair), Matrix};
-    return td;
+    Status = CUT_DONE;
+    return std::unique_ptr<TransitionData>(new TransitionData{FoliationDisk(Lengths, Pair), Matrix});
 }
 
 
@@ -429,37 +839,44 @@ FoliationRP2::TransitionData FoliationRP2::CutAlongCurve(const GoodOneSidedCurve
 
 
 
-void FoliationRP2::FindNewPseudoAnosovs(const GoodOneSidedCurve& GoodCurve){
-    try {
-        TransitionData td = CutAlongCurve(GoodCurve);
-        for (int Round = 0; Round < 2; Round++) {
-            for (int i = 0; i < m_NumSeparatrices; i++) {
-                if (ArePairsEqual(td.m_NewFoliationDisk, *this)) {
-                    AlmostPFMatrix Matrix(GetSmallMatrix(td));
-                    // std::cout << Matrix << std::endl << std::endl;
+template <typename Precision>
+void FoliationRP2<Precision>::FindNewPseudoAnosovs(const GoodOneSidedCurve& GoodCurve){
+    CutStatus Status;
+    std::unique_ptr<TransitionData> Cut = CutAlongCurve(GoodCurve, Status);
+    if (Status == CUT_SADDLE_CONNECTION) {
+        std::cout << "*** Could not complete search for pseudo-anosovs due to found saddle connection. ***\n";
+    }
+    if (Cut == NULL) {
+        return;
+    }
+    TransitionData& td = *Cut;
+    if (!ArePairsEqualUpToRotationAndReflection(td.m_NewFoliationDisk, *this)) {
+        return;
+    }
+    for (int Round = 0; Round < 2; Round++) {
+        for (int i = 0; i < m_NumSeparatrices; i++) {
+            if (ArePairsEqual(td.m_NewFoliationDisk, *this)) {
+                AlmostPFMatrix Matrix(GetSmallMatrix(td));
+                // std::cout << Matrix << std::endl << std::endl;
+                
+                if (Matrix.IsPerronFrobenius()) {
+                    std::vector<floating_point_type> SmallLengthVector = Matrix.GetPFEigenvector();
                     
-                    if (Matrix.IsPerronFrobenius()) {
-                        std::vector<floating_point_type> SmallLengthVector = Matrix.GetPFEigenvector();
-                        
-                        std::vector<floating_point_type> NewLengths(m_NumSeparatrices);
-                        for (int j = 0; j < m_NumSeparatrices/2; j++) {
-                            NewLengths[2 * j] = SmallLengthVector[j];
-                            NewLengths[m_Pair[2 * j]] = SmallLengthVector[j];
-                        }
-                        FoliationRP2 NewCandidate(NewLengths, m_Pair);
-                        RotationData r = {Round == 0 ? false : true, i};
-                        
-                        NewCandidate.CheckSelfSimilarity(GoodCurve.m_SegmentShiftedToLeft.m_Separatrix, GoodCurve.m_SegmentShiftedToLeft.m_Depth, LEFT, GoodCurve.m_SegmentShiftedToRight.m_Depth, r);
+                    std::vector<floating_point_type> NewLengths(m_NumSeparatrices);
+                    for (int j = 0; j < m_NumSeparatrices/2; j++) {
+                        NewLengths[2 * j] = SmallLengthVector[j];
+                        NewLengths[m_Pair[2 * j]] = SmallLengthVector[j];
                     }
+                    FoliationRP2 NewCandidate(NewLengths, m_Pair);
+                    RotationData r = {Round == 0 ? false : true, i};
+                    
+                    NewCandidate.CheckSelfSimilarity(GoodCurve.m_SegmentShiftedToLeft.m_Separatrix, GoodCurve.m_SegmentShiftedToLeft.m_Depth, LEFT, GoodCurve.m_SegmentShiftedToRight.m_Depth, r);
                 }
-                td.Rotate();
             }
-            td.Reflect();
+            td.Rotate();
         }
-    } catch (const ExceptionFoundSaddleConnection&) {
-        std::cout << "*** Could not complete search for pseudo-anosovs due to found saddle connection. ***\n";
+        td.Reflect();
     }
-    
 }
 
 
@@ -467,18 +884,21 @@ void FoliationRP2::FindNewPseudoAnosovs(const GoodOneSidedCurve& GoodCurve){
 
 
 
-Arc FoliationRP2::GetClosingArcIfGoodOneSidedCurve(const SeparatrixSegment& Segment1, const SeparatrixSegment& Segment2){
-    ArcsAroundDivPoints Intersection = Intersect(Segment1.m_ArcsAroundDivPoints, Segment2.m_ArcsAroundDivPoints);
-    
+// Sets ClosingArc and returns true if the two segments can be closed up to a good curve, false if not. The Arcs of
+// the two segments are intersected only as far as needed for each closing arc, see IntersectionContainsArcThroughADivPointQ.
+template <typename Precision>
+bool FoliationRP2<Precision>::GetClosingArcIfGoodOneSidedCurve(const SeparatrixSegment& Segment1, const SeparatrixSegment& Segment2, Arc& ClosingArc) const{
     Arc Arc1(Segment1.m_Endpoint, Segment2.m_Endpoint);
-    if(Intersection.ContainsArcThroughADivPointQ(Arc1)){
-        return Arc1;
+    if (IntersectionContainsArcThroughADivPointQ(Segment1.m_ArcsAroundDivPoints, Segment2.m_ArcsAroundDivPoints, Arc1)) {
+        ClosingArc = Arc1;
+        return true;
     }
     Arc Arc2(Segment2.m_Endpoint, Segment1.m_Endpoint);
-    if (Intersection.ContainsArcThroughADivPointQ(Arc2)){
-        return Arc2;
+    if (IntersectionContainsArcThroughADivPointQ(Segment1.m_ArcsAroundDivPoints, Segment2.m_ArcsAroundDivPoints, Arc2)) {
+        ClosingArc = Arc2;
+        return true;
     }
-    throw ExceptionNoObjectFound();
+    return false;
 }
 
 
@@ -488,7 +908,8 @@ Arc FoliationRP2::GetClosingArcIfGoodOneSidedCurve(const SeparatrixSegment& Segm
 
 
 
-bool FoliationRP2::AreDepthsGoodForOneSidedCurve(int Depth1, int Depth2){
+template <typename Precision>
+bool FoliationRP2<Precision>::AreDepthsGoodForOneSidedCurve(int Depth1, int Depth2) const{
     if (Depth1 % 2 == 1 && abs(Depth1 - Depth2) % 4 == 2) {
         return true;
     }
@@ -501,15 +922,14 @@ bool FoliationRP2::AreDepthsGoodForOneSidedCurve(int Depth1, int Depth2){
 
 
 
-FoliationRP2::GoodOneSidedCurve FoliationRP2::GetGoodOneSidedCurve(const SeparatrixSegment& SegmentShiftedToLeft,
-                                                                    const SeparatrixSegment& SegmentShiftedToRight){
-    if (AreDepthsGoodForOneSidedCurve(SegmentShiftedToRight.m_Depth, SegmentShiftedToLeft.m_Depth)) {
-        Arc myArc = GetClosingArcIfGoodOneSidedCurve(SegmentShiftedToRight, SegmentShiftedToLeft);
-        if (myArc.GetLeftEndpoint().IsShiftedTo(LEFT)) {
-            return GoodOneSidedCurve(SegmentShiftedToLeft, SegmentShiftedToRight, myArc);
-        }
-    }
-    throw ExceptionNoObjectFound();
+// Sets ConnectingArc and returns true if the two segments form a GoodOneSidedCurve. Most pairs don't, and they are
+// rejected on their depths before the arcs are intersected.
+template <typename Precision>
+bool FoliationRP2<Precision>::IsGoodOneSidedCurve(const SeparatrixSegment& SegmentShiftedToLeft, const SeparatrixSegment& SegmentShiftedToRight,
+                                                  Arc& ConnectingArc) const{
+    return AreDepthsGoodForOneSidedCurve(SegmentShiftedToRight.m_Depth, SegmentShiftedToLeft.m_Depth) &&
+           GetClosingArcIfGoodOneSidedCurve(SegmentShiftedToRight, SegmentShiftedToLeft, ConnectingArc) &&
+           ConnectingArc.GetLeftEndpoint().IsShiftedTo(LEFT);
 }
 
 
@@ -519,7 +939,8 @@ FoliationRP2::GoodOneSidedCurve FoliationRP2::GetGoodOneSidedCurve(const Separat
 
 
 
-bool FoliationRP2::Compare(const GoodOneSidedCurve& c1, const GoodOneSidedCurve& c2){
+template <typename Precision>
+bool FoliationRP2<Precision>::Compare(const GoodOneSidedCurve& c1, const GoodOneSidedCurve& c2){
     if (c1.m_ConnectingArc.GetLength() > c2.m_ConnectingArc.GetLength()) {
         return true;
     }
@@ -533,7 +954,8 @@ bool FoliationRP2::Compare(const GoodOneSidedCurve& c1, const GoodOneSidedCurve&
 
 
 
-std::ostream& operator<<(std::ostream& Out, const FoliationRP2::GoodOneSidedCurve& GoodCurve)
+template <typename Precision>
+std::ostream& FoliationRP2<Precision>::Print(std::ostream& Out, const GoodOneSidedCurve& GoodCurve)
 {    
     Out << "Separatrix segments (separatrix index, depth, endpoint): (" << GoodCurve.m_SegmentShiftedToLeft.m_Separatrix << ", "
     << GoodCurve.m_SegmentShiftedToLeft.m_Depth << ", " << GoodCurve.m_SegmentShiftedToLeft.m_Endpoint << "), (" <<
@@ -559,7 +981,8 @@ std::ostream& operator<<(std::ostream& Out, const FoliationRP2::GoodOneSidedCurv
 
 
 
-void FoliationRP2::TransitionData::Rotate(){
+template <typename Precision>
+void FoliationRP2<Precision>::TransitionData::Rotate(){
     m_NewFoliationDisk.Rotate();
     m_TransitionMatrix.Rotate();
 }
@@ -567,14 +990,16 @@ void FoliationRP2::TransitionData::Rotate(){
 
 
 
-void FoliationRP2::TransitionData::Reflect(){
+template <typename Precision>
+void FoliationRP2<Precision>::TransitionData::Reflect(){
     m_NewFoliationDisk.Reflect();
     m_TransitionMatrix.Reflect();
 }
 
 
 
-void FoliationRP2::TransitionData::Rotate(RotationData r){
+template <typename Precision>
+void FoliationRP2<Precision>::TransitionData::Rotate(RotationData r){
     if (r.m_Reflection == true) {
         Reflect();
     }
@@ -595,7 +1020,8 @@ void FoliationRP2::TransitionData::Rotate(RotationData r){
 
 
 
-AlmostPFMatrix FoliationRP2::GetSmallMatrix(const TransitionData& td){
+template <typename Precision>
+AlmostPFMatrix<Precision> FoliationRP2<Precision>::GetSmallMatrix(const TransitionData& td){
     int Size = m_NumSeparatrices/2;
     std::vector<std::vector<int>> Matrix(Size, std::vector<int>(Size));
 
@@ -629,8 +1055,16 @@ AlmostPFMatrix FoliationRP2::GetSmallMatrix(const TransitionData& td){
 
 
 
-FoliationRP2::FoliationRP2(const WeighedTree& wt) :
-    FoliationDisk(wt)
+template <typename Precision>
+FoliationRP2<Precision>::FoliationRP2(const WeighedTree& wt) :
+    FoliationDisk(wt),
+    m_PreciseFoliation(wt),
+    m_StepMap(*this),
+    m_PreciseStepMap(m_PreciseFoliation),
+    m_PreciseInductionFailed(false),
+    m_NumThreads(1),
+    m_StateDatabase(NULL),
+    m_LastStateSave(std::chrono::steady_clock::now())
 {
     Init();
 }
@@ -638,8 +1072,34 @@ FoliationRP2::FoliationRP2(const WeighedTree& wt) :
 
 
 
-FoliationRP2::FoliationRP2(const std::vector<floating_point_type>& Lengths, const std::vector<int>& Pair) :
-    FoliationDisk(Lengths, Pair)
+template <typename Precision>
+FoliationRP2<Precision>::FoliationRP2(const std::vector<floating_point_type>& Lengths, const std::vector<int>& Pair) :
+    FoliationDisk(Lengths, Pair),
+    m_PreciseFoliation(std::vector<precise_floating_point_type>(Lengths.begin(), Lengths.end()), Pair),
+    m_StepMap(*this),
+    m_PreciseStepMap(m_PreciseFoliation),
+    m_PreciseInductionFailed(false),
+    m_NumThreads(1),
+    m_StateDatabase(NULL),
+    m_LastStateSave(std::chrono::steady_clock::now())
+{
+    Init();
+}
+
+
+
+
+template <typename Precision>
+FoliationRP2<Precision>::FoliationRP2(const std::vector<floating_point_type>& Lengths, const std::vector<int>& Pair,
+                                      const std::vector<precise_floating_point_type>& PreciseLengths) :
+    FoliationDisk(Lengths, Pair),
+    m_PreciseFoliation(PreciseLengths, Pair),
+    m_StepMap(*this),
+    m_PreciseStepMap(m_PreciseFoliation),
+    m_PreciseInductionFailed(false),
+    m_NumThreads(1),
+    m_StateDatabase(NULL),
+    m_LastStateSave(std::chrono::steady_clock::now())
 {
     Init();
 }
@@ -650,20 +1110,64 @@ FoliationRP2::FoliationRP2(const std::vector<floating_point_type>& Lengths, cons
 
 
 
-void FoliationRP2::Init(){
+template <typename Precision>
+void FoliationRP2<Precision>::Init(){
     m_GoodShiftedSeparatrixSegments.resize(m_NumSeparatrices);
     m_FoundSaddleConnectionQ.resize(m_NumSeparatrices, 0);
-    m_CurrentSepSegments.resize(m_NumSeparatrices, m_DivPoints);
+    for (int i = 0; i < m_NumSeparatrices; i++) {
+        m_CurrentSepSegments.push_back(SeparatrixSegment(m_DivPoints));    // not copies of one, whose counts would share a base across threads
+    }
+    m_InducedMaps.resize(m_NumSeparatrices);
+    m_NextInductionMeasure.resize(m_NumSeparatrices, m_StepMap.GetMeasure() / INDUCTION_REFINEMENT_RATIO);
+    m_NextInductionDepth.resize(m_NumSeparatrices, INDUCTION_MIN_DEPTH);
+    m_CountCheckpoints.resize(m_NumSeparatrices);
+    m_NumSavedGoodSegments.resize(m_NumSeparatrices, std::vector<int>(2, 0));
+    m_NumSavedCountCheckpoints.resize(m_NumSeparatrices, 0);
+    m_NumPairedGoodSegments.resize(m_NumSeparatrices, std::vector<int>(2, 0));
+    m_PairedLeftIndicesByDepth.resize(m_NumSeparatrices, std::vector<std::vector<int>>(4));
+    m_SavedLogSize = 0;
 
     
+    m_GoodEndpointIndices.resize(m_NumSeparatrices);
     for (int i = 0; i < m_NumSeparatrices; i++) {
         m_GoodShiftedSeparatrixSegments[i].resize(2);
+        m_GoodEndpointIndices[i].resize(2);
+    }
+    
+    // A division point of m_PreciseFoliation is a sum of up to m_NumSeparatrices lengths, each rounded when it was
+    // given and when it was normalized, so it is off by at most 3 * m_NumSeparatrices roundings. The division points
+    // in the original precision are off by their distance from those, and by that much more. The step error covers
+    // the error of two division points (m_TempForFollowTheLeaf is their sum) and the rounding of the step itself.
+    m_PreciseDivPointError = 3 * m_NumSeparatrices * PreciseCirclePoint::Coordinate::template RoundingError<precise_floating_point_type>();
+    m_DivPointError = 0;
+    m_PreciseOrbits.resize(m_NumSeparatrices);
+    for (int i = 0; i < m_NumSeparatrices; i++) {
+        PreciseCirclePoint DivPoint(precise_floating_point_type(m_DivPoints[i].GetValue()));
+        const PreciseCirclePoint& PreciseDivPoint = m_PreciseFoliation.GetDivPoint(i);
+        precise_floating_point_type Error = DistanceBetween(DivPoint, PreciseDivPoint) < DistanceBetween(PreciseDivPoint, DivPoint) ?
+                                            DistanceBetween(DivPoint, PreciseDivPoint) : DistanceBetween(PreciseDivPoint, DivPoint);
+        if (m_DivPointError < static_cast<floating_point_type>(Error)) {
+            m_DivPointError = static_cast<floating_point_type>(Error);
+        }
+        
+        m_PreciseOrbits[i].m_Depth = 1;
+        m_PreciseOrbits[i].m_Endpoint = PreciseDivPoint;
+        m_PreciseOrbits[i].m_EndpointIntervalIndex = m_PreciseFoliation.WhichIntervalContains(PreciseDivPoint);
+        m_PreciseOrbits[i].m_ErrorBound = m_PreciseDivPointError;
     }
+    m_DivPointError += static_cast<floating_point_type>(m_PreciseDivPointError);
+    m_StepError = 2 * m_DivPointError + 4 * CirclePoint::Coordinate::template RoundingError<floating_point_type>();
+    m_PreciseStepError = 2 * m_PreciseDivPointError + 4 * PreciseCirclePoint::Coordinate::template RoundingError<precise_floating_point_type>();
 	
 	for (int i = 0; i < m_NumSeparatrices; i++) { 
         m_CurrentSepSegments[i].m_Separatrix = i; 
         m_CurrentSepSegments[i].m_Endpoint = m_DivPoints[i];
+        m_CurrentSepSegments[i].m_EndpointIntervalIndex = WhichIntervalContains(m_DivPoints[i]);
+        m_CurrentSepSegments[i].m_ErrorBound = m_DivPointError;
         
+        if (COUNT_CHECKPOINT_SPACING > 0) {
+            SaveCountCheckpoint(m_CurrentSepSegments[i], INT_MAX);
+        }
         AddToGoodSegmentsIfGood(m_CurrentSepSegments[i]);
     }
 }
@@ -685,13 +1189,376 @@ void FoliationRP2::Init(){
 
 
 
-void FoliationRP2::PrintGoodShiftedSeparatrixSegmentsVerbose(int Depth){
+// The file name has a hash of the pairing and the division points, the file itself has them exactly (IsStateKey).
+template <typename Precision>
+std::string FoliationRP2<Precision>::GetStateName() const{
+    std::size_t Hash = m_NumSeparatrices;
+    for (int i = 0; i < m_NumSeparatrices; i++) {
+        Hash ^= std::hash<double>()(static_cast<double>(m_DivPoints[i].GetValue())) + m_Pair[i] + 0x9e3779b9 + (Hash << 6) + (Hash >> 2);
+    }
+    std::ostringstream Name;
+    Name << "FoliationRP2_" << typeid(Precision).name() << "_" << std::hex << Hash;
+    return Name.str();
+}
+
+
+
+
+// The constants that decide how the separatrices are followed, so a saved search is not continued differently.
+template <typename Precision>
+std::vector<int> FoliationRP2<Precision>::GetStateConstants(){
+    std::vector<int> Constants;
+    Constants.push_back(INDUCTION_MIN_DEPTH);
+    Constants.push_back(INDUCTION_REFINEMENT_RATIO);
+    Constants.push_back(INDUCTION_TOLERANCE);
+    Constants.push_back(INDUCTION_WORK_FACTOR);
+    Constants.push_back(COUNT_CHECKPOINT_SPACING);
+    return Constants;
+}
+
+
+
+
+template <typename Precision>
+void FoliationRP2<Precision>::WriteStateKey(StateWriter& Writer) const{
+    Writer.Write(std::string(typeid(Precision).name()));
+    Writer.Write(GetStateConstants());
+    Writer.Write(m_Pair);
+    for (int i = 0; i < m_NumSeparatrices; i++) {
+        Writer.Write(m_DivPoints[i].GetCoordinate());
+        Writer.Write(m_PreciseFoliation.GetDivPoint(i).GetCoordinate());
+    }
+}
+
+
+
+
+// The coordinates are compared as numbers, since their bytes in memory need not be the same (long double has unused
+// bytes).
+template <typename Precision>
+bool FoliationRP2<Precision>::IsStateKey(StateReader& Reader) const{
+    std::string PrecisionName;
+    std::vector<int> Constants;
+    std::vector<int> Pair;
+    Reader.Read(PrecisionName);
+    Reader.Read(Constants);
+    Reader.Read(Pair);
+    if (PrecisionName != typeid(Precision).name() || Constants != GetStateConstants() || Pair != m_Pair) {
+        return false;
+    }
+    for (int i = 0; i < m_NumSeparatrices; i++) {
+        if (!(Reader.Read<circle_coordinate_type>() == m_DivPoints[i].GetCoordinate()) ||
+            !(Reader.Read<typename PreciseFoliationDisk::circle_coordinate_type>() == m_PreciseFoliation.GetDivPoint(i).GetCoordinate())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+
+
+// A whole circle Arc is written with a flag, see the ArcArray constructor from Arcs.
+template <typename Precision>
+void FoliationRP2<Precision>::Write(StateWriter& Writer, const SeparatrixSegment& s){
+    Writer.Write(s.m_Separatrix);
+    Writer.Write(s.m_Depth);
+    Writer.Write(s.m_Endpoint);
+    Writer.Write(s.m_EndpointIntervalIndex);
+    Writer.Write(s.m_ErrorBound);
+    std::vector<Arc> Arcs = s.m_ArcsAroundDivPoints.GetArcs();
+    Writer.Write(static_cast<int>(Arcs.size()));
+    for (int k = 0; k < Arcs.size(); k++) {
+        Writer.Write(Arcs[k].GetLeftEndpoint());
+        Writer.Write(Arcs[k].GetRightEndpoint());
+        Writer.Write(Arcs[k].GetLeftEndpoint() == Arcs[k].GetRightEndpoint() && Arcs[k].GetLength() == 1);
+    }
+    Writer.Write(s.m_IntervalIntersectionCount.ToVector());
+    Writer.Write(s.m_Side);
+}
+
+
+
+
+template <typename Precision>
+void FoliationRP2<Precision>::Read(StateReader& Reader, SeparatrixSegment& s) const{
+    Reader.Read(s.m_Separatrix);
+    Reader.Read(s.m_Depth);
+    Reader.Read(s.m_Endpoint);
+    Reader.Read(s.m_EndpointIntervalIndex);
+    Reader.Read(s.m_ErrorBound);
+    int NumArcs = Reader.Read<int>();
+    if (NumArcs != 0 && NumArcs != m_NumSeparatrices) {
+        throw ExceptionCorruptState();
+    }
+    std::vector<Arc> Arcs;
+    for (int k = 0; k < NumArcs; k++) {
+        CirclePoint LeftEndpoint = Reader.Read<CirclePoint>();
+        CirclePoint RightEndpoint = Reader.Read<CirclePoint>();
+        Arcs.push_back(Reader.Read<bool>() ? Arc(LeftEndpoint) : Arc(LeftEndpoint, RightEndpoint));
+    }
+    s.m_ArcsAroundDivPoints.SetArcs(Arcs);
+    std::vector<int> Count;
+    Reader.Read(Count);
+    if (!Count.empty() && Count.size() != m_NumSeparatrices) {
+        throw ExceptionCorruptState();
+    }
+    s.m_IntervalIntersectionCount = SharedVector<int>(Count);
+    Reader.Read(s.m_Side);
+}
+
+
+
+
+template <typename Precision>
+void FoliationRP2<Precision>::Write(StateWriter& Writer, const CountCheckpoint& c){
+    Writer.Write(c.m_Depth);
+    Writer.Write(c.m_Endpoint);
+    Writer.Write(c.m_EndpointIntervalIndex);
+    Writer.Write(c.m_ErrorBound);
+    Writer.Write(c.m_IntervalIntersectionCount);
+    Writer.Write(c.m_NumInducedMaps);
+    Writer.Write(c.m_MaxDepth);
+}
+
+
+
+
+template <typename Precision>
+void FoliationRP2<Precision>::Read(StateReader& Reader, CountCheckpoint& c) const{
+    Reader.Read(c.m_Depth);
+    Reader.Read(c.m_Endpoint);
+    Reader.Read(c.m_EndpointIntervalIndex);
+    Reader.Read(c.m_ErrorBound);
+    Reader.Read(c.m_IntervalIntersectionCount);
+    Reader.Read(c.m_NumInducedMaps);
+    Reader.Read(c.m_MaxDepth);
+    if (c.m_IntervalIntersectionCount.size() != m_NumSeparatrices) {
+        throw ExceptionCorruptState();
+    }
+}
+
+
+
+
+// The good segments and the count checkpoints found since the last save are appended to the log, except for the last
+// checkpoint of each separatrix, which can still be replaced by one of the same depth (SaveCountCheckpoint). The file
+// has the rest: the length of the log, and for each separatrix the current segment, the checkpoints not in the log and
+// the induced maps. Then what is one vector for all separatrices.
+template <typename Precision>
+bool FoliationRP2<Precision>::SaveState(const OrbitDatabase& Database){
+    if (!Database.IsEnabled()) {
+        return false;
+    }
+    StateWriter Log;
+    for (int i = 0; i < m_NumSeparatrices; i++) {
+        for (int Side = LEFT; Side <= RIGHT; Side++) {
+            const AppendOnlyStore<SeparatrixSegment>& Segments = m_GoodShiftedSeparatrixSegments[i][Side];
+            for (int k = m_NumSavedGoodSegments[i][Side]; k < Segments.Size(); k++) {
+                Log.Write(i);
+                Log.Write(Side);
+                Write(Log, Segments[k]);
+            }
+        }
+        for (int k = m_NumSavedCountCheckpoints[i]; k < static_cast<int>(m_CountCheckpoints[i].size()) - 1; k++) {
+            Log.Write(i);
+            Log.Write(COUNT_CHECKPOINT_RECORD);
+            Write(Log, m_CountCheckpoints[i][k]);
+        }
+    }
+    long long LogSize = m_SavedLogSize + static_cast<long long>(Log.GetBytes().size());
+    if (!Database.AppendToLog(GetStateName(), m_SavedLogSize, Log)) {
+        return false;
+    }
+    
+    StateWriter Writer;
+    WriteStateKey(Writer);
+    Writer.Write(LogSize);
+    for (int i = 0; i < m_NumSeparatrices; i++) {
+        Write(Writer, m_CurrentSepSegments[i]);
+        int NumCountCheckpoints = std::max(static_cast<int>(m_CountCheckpoints[i].size()) - 1, m_NumSavedCountCheckpoints[i]);
+        Writer.Write(static_cast<int>(m_CountCheckpoints[i].size()) - NumCountCheckpoints);
+        for (int k = NumCountCheckpoints; k < m_CountCheckpoints[i].size(); k++) {
+            Write(Writer, m_CountCheckpoints[i][k]);
+        }
+        Writer.Write(static_cast<int>(m_InducedMaps[i].size()));
+        for (int k = 0; k < m_InducedMaps[i].size(); k++) {
+            m_InducedMaps[i][k].Write(Writer);
+        }
+    }
+    Writer.Write(m_FoundSaddleConnectionQ);
+    Writer.Write(m_PreciseOrbits);
+    Writer.Write(m_NextInductionMeasure);
+    Writer.Write(m_NextInductionDepth);
+    Writer.Write(static_cast<int>(m_PreciseInducedMaps.size()));
+    for (int k = 0; k < m_PreciseInducedMaps.size(); k++) {
+        m_PreciseInducedMaps[k].Write(Writer);
+    }
+    Writer.Write(m_PreciseInductionRadius);
+    Writer.Write(m_PreciseInductionFailed);
+    if (!Database.Store(GetStateName(), Writer)) {
+        return false;       // the log is cut back at the next save
+    }
+    
+    m_SavedLogSize = LogSize;
+    for (int i = 0; i < m_NumSeparatrices; i++) {
+        for (int Side = LEFT; Side <= RIGHT; Side++) {
+            m_NumSavedGoodSegments[i][Side] = m_GoodShiftedSeparatrixSegments[i][Side].Size();
+        }
+        m_NumSavedCountCheckpoints[i] = std::max(static_cast<int>(m_CountCheckpoints[i].size()) - 1, m_NumSavedCountCheckpoints[i]);
+    }
+    return true;
+}
+
+
+
+
+// Called between two steps of a search, when the state is complete. Looking at the clock only every so many steps is
+// left to the caller.
+template <typename Precision>
+void FoliationRP2<Precision>::SaveStateIfDue(){
+    if (m_StateDatabase == NULL ||
+        std::chrono::steady_clock::now() - m_LastStateSave < std::chrono::seconds(STATE_SAVE_INTERVAL)) {
+        return;
+    }
+    SaveState(*m_StateDatabase);
+    m_LastStateSave = std::chrono::steady_clock::now();
+}
+
+
+
+
+// Everything is read into new containers first, so the object is left as it was if the file or the log is not
+// complete. The checkpoints in the log come before the ones in the file. The indices of the good endpoints are rebuilt
+// in the order the segments were found.
+template <typename Precision>
+bool FoliationRP2<Precision>::LoadState(const OrbitDatabase& Database){
+    StateReader Reader;
+    if (!Database.Open(GetStateName(), Reader)) {
+        return false;
+    }
+    long long LogSize;
+    std::vector<SeparatrixSegment> CurrentSepSegments(m_NumSeparatrices, SeparatrixSegment(m_DivPoints));
+    std::vector<std::vector<AppendOnlyStore<SeparatrixSegment>>> GoodShiftedSeparatrixSegments(m_NumSeparatrices,
+                                                                                                std::vector<AppendOnlyStore<SeparatrixSegment>>(2));
+    std::vector<std::vector<CountCheckpoint>> CountCheckpoints(m_NumSeparatrices);
+    std::vector<std::vector<CountCheckpoint>> NewCountCheckpoints(m_NumSeparatrices);     // the ones not in the log
+    std::vector<std::vector<InducedMap>> InducedMaps(m_NumSeparatrices);
+    std::vector<char> FoundSaddleConnectionQ;
+    std::vector<PreciseOrbit> PreciseOrbits;
+    std::vector<floating_point_type> NextInductionMeasure;
+    std::vector<int> NextInductionDepth;
+    std::deque<PreciseInducedMap> PreciseInducedMaps;
+    std::vector<precise_floating_point_type> PreciseInductionRadius;
+    bool PreciseInductionFailed;
+    try {
+        if (!IsStateKey(Reader)) {
+            return false;
+        }
+        Reader.Read(LogSize);
+        for (int i = 0; i < m_NumSeparatrices; i++) {
+            Read(Reader, CurrentSepSegments[i]);
+            NewCountCheckpoints[i].resize(std::max(Reader.Read<int>(), 0));
+            for (int k = 0; k < NewCountCheckpoints[i].size(); k++) {
+                Read(Reader, NewCountCheckpoints[i][k]);
+            }
+            int NumInducedMaps = Reader.Read<int>();
+            for (int k = 0; k < NumInducedMaps; k++) {
+                InducedMaps[i].push_back(InducedMap(Reader));
+            }
+        }
+        Reader.Read(FoundSaddleConnectionQ);
+        Reader.Read(PreciseOrbits);
+        Reader.Read(NextInductionMeasure);
+        Reader.Read(NextInductionDepth);
+        int NumPreciseInducedMaps = Reader.Read<int>();
+        for (int k = 0; k < NumPreciseInducedMaps; k++) {
+            PreciseInducedMaps.push_back(PreciseInducedMap(Reader));
+        }
+        Reader.Read(PreciseInductionRadius);
+        Reader.Read(PreciseInductionFailed);
+        if (!Reader.IsAtEnd() || FoundSaddleConnectionQ.size() != m_NumSeparatrices || PreciseOrbits.size() != m_NumSeparatrices ||
+            NextInductionMeasure.size() != m_NumSeparatrices || NextInductionDepth.size() != m_NumSeparatrices ||
+            PreciseInductionRadius.size() != PreciseInducedMaps.size()) {
+            return false;
+        }
+        
+        if (!Database.OpenLog(GetStateName(), LogSize, Reader)) {
+            return false;
+        }
+        while (!Reader.IsAtEnd()) {
+            int i = Reader.Read<int>();
+            int Kind = Reader.Read<int>();
+            if (i < 0 || i >= m_NumSeparatrices) {
+                return false;
+            }
+            if (Kind == COUNT_CHECKPOINT_RECORD) {
+                CountCheckpoints[i].push_back(CountCheckpoint());
+                Read(Reader, CountCheckpoints[i].back());
+            } else if (Kind == LEFT || Kind == RIGHT) {
+                SeparatrixSegment s(m_DivPoints);
+                Read(Reader, s);
+                GoodShiftedSeparatrixSegments[i][Kind].PushBack(s);
+            } else {
+                return false;
+            }
+        }
+    } catch (const ExceptionCorruptState&) {
+        return false;
+    }
+    
+    for (int i = 0; i < m_NumSeparatrices; i++) {
+        m_NumSavedCountCheckpoints[i] = static_cast<int>(CountCheckpoints[i].size());
+        CountCheckpoints[i].insert(CountCheckpoints[i].end(), NewCountCheckpoints[i].begin(), NewCountCheckpoints[i].end());
+        for (int Side = LEFT; Side <= RIGHT; Side++) {
+            m_NumSavedGoodSegments[i][Side] = GoodShiftedSeparatrixSegments[i][Side].Size();
+        }
+    }
+    m_SavedLogSize = LogSize;
+    m_CurrentSepSegments.swap(CurrentSepSegments);
+    m_GoodShiftedSeparatrixSegments.swap(GoodShiftedSeparatrixSegments);
+    m_CountCheckpoints.swap(CountCheckpoints);
+    m_InducedMaps.swap(InducedMaps);
+    m_FoundSaddleConnectionQ.swap(FoundSaddleConnectionQ);
+    m_PreciseOrbits.swap(PreciseOrbits);
+    m_NextInductionMeasure.swap(NextInductionMeasure);
+    m_NextInductionDepth.swap(NextInductionDepth);
+    m_PreciseInducedMaps.swap(PreciseInducedMaps);
+    m_PreciseInductionRadius.swap(PreciseInductionRadius);
+    m_PreciseInductionFailed = PreciseInductionFailed;
+    for (int i = 0; i < m_NumSeparatrices; i++) {
+        for (LeftOrRight Side = LEFT; Side < 2; Side++) {
+            const AppendOnlyStore<SeparatrixSegment>& Segments = m_GoodShiftedSeparatrixSegments[i][Side];
+            m_GoodEndpointIndices[i][Side] = RangeMinimumIndex<circle_coordinate_type>();
+            for (int k = 0; k < Segments.Size(); k++) {
+                m_GoodEndpointIndices[i][Side].Insert(Segments[k].m_Endpoint.GetCoordinate(), k);
+            }
+        }
+    }
+    return true;
+}
+
+
+
+
+
+
+
+
+
+
+
+
+template <typename Precision>
+void FoliationRP2<Precision>::PrintGoodShiftedSeparatrixSegmentsVerbose(int Depth){
     GenerateGoodShiftedSeparatrixSegments(Depth);
     for (int i = 0; i < m_NumSeparatrices; i++) {
         for (LeftOrRight Side = LEFT; Side < 2; Side++) {
-            for(std::list<SeparatrixSegment>::iterator it = m_GoodShiftedSeparatrixSegments[i][Side].begin(); it != m_GoodShiftedSeparatrixSegments[i][Side].end() && it->m_Depth < Depth; it++)
-            {
-                std::cout << *it << std::endl;
+            const AppendOnlyStore<SeparatrixSegment>& Segments = m_GoodShiftedSeparatrixSegments[i][Side];
+            for (int k = 0; k < FindDepth(Segments, Depth); k++) {
+                SeparatrixSegment s = Segments[k];
+                s.m_IntervalIntersectionCount = SharedVector<int>(GetIntervalIntersectionCount(s));
+                std::cout << s << std::endl;
             }
         }
     }
@@ -699,7 +1566,8 @@ void FoliationRP2::PrintGoodShiftedSeparatrixSegmentsVerbose(int Depth){
 
 
 
-void FoliationRP2::PrintGoodShiftedSeparatrixSegmentsConcise(int Depth){
+template <typename Precision>
+void FoliationRP2<Precision>::PrintGoodShiftedSeparatrixSegmentsConcise(int Depth){
     using namespace std;
     GenerateGoodShiftedSeparatrixSegments(Depth);
 
@@ -707,10 +1575,10 @@ void FoliationRP2::PrintGoodShiftedSeparatrixSegmentsConcise(int Depth){
         cout << "SeparatrixIndex: " << i << "\n";
         for (LeftOrRight Side = LEFT; Side < 2; Side++) {
             cout << (Side == LEFT ? "LEFT: " : "RIGHT: ");
-            for(std::list<SeparatrixSegment>::iterator it = m_GoodShiftedSeparatrixSegments[i][Side].begin(); it != m_GoodShiftedSeparatrixSegments[i][Side].end() && it->m_Depth < Depth; it++)
-            {
-                if (it->m_Depth % 2 == 1) {
-                    std::cout << it->m_Depth << " ";
+            const AppendOnlyStore<SeparatrixSegment>& Segments = m_GoodShiftedSeparatrixSegments[i][Side];
+            for (int k = 0; k < FindDepth(Segments, Depth); k++) {
+                if (Segments[k].m_Depth % 2 == 1) {
+                    std::cout << Segments[k].m_Depth << " ";
                 }
             }
             cout << "\n";
@@ -722,57 +1590,177 @@ void FoliationRP2::PrintGoodShiftedSeparatrixSegmentsConcise(int Depth){
 
 
 
-void FoliationRP2::PrintGoodCurves(int Depth){
+template <typename Precision>
+void FoliationRP2<Precision>::PrintGoodCurves(int Depth){
     GenerateGoodCurves(Depth);
-    for (std::list<GoodOneSidedCurve>::iterator it = m_GoodOneSidedCurves.begin(); it != m_GoodOneSidedCurves.end(); it++) {
+    for (typename std::list<GoodOneSidedCurve>::iterator it = m_GoodOneSidedCurves.begin(); it != m_GoodOneSidedCurves.end(); it++) {
         std::cout << *it << std::endl;
     }
 }
 
 
 
-void FoliationRP2::GenerateGoodShiftedSeparatrixSegments(int Depth){
+// Up to INDUCTION_MIN_DEPTH the separatrices are lengthened together, one step at a time. Their next intersections are
+// computed in one batch by AdvanceOrbits, the rest of Lengthen is done one separatrix at a time. A separatrix leaves the
+// batch when it reaches that depth or a saddle connection. From there on each separatrix skips ahead with Advance,
+// on a ThreadPool if there are m_NumThreads > 1 (see THREADS in FoliationRP2.h).
+template <typename Precision>
+void FoliationRP2<Precision>::GenerateGoodShiftedSeparatrixSegments(int Depth){
+    const int BatchDepth = Depth < INDUCTION_MIN_DEPTH ? Depth : INDUCTION_MIN_DEPTH;
+    std::vector<int> Separatrix;        // the separatrix in each lane of Batch
     for (int SeparatrixIndex = 0; SeparatrixIndex < m_NumSeparatrices; SeparatrixIndex++) {
-        while (!m_FoundSaddleConnectionQ[SeparatrixIndex] && m_CurrentSepSegments[SeparatrixIndex].m_Depth < Depth) {
-            Lengthen(m_CurrentSepSegments[SeparatrixIndex]);
+        if (!m_FoundSaddleConnectionQ[SeparatrixIndex] && m_CurrentSepSegments[SeparatrixIndex].m_Depth < BatchDepth) {
+            Separatrix.push_back(SeparatrixIndex);
         }
     }
+    OrbitBatch Batch;
+    Batch.Resize(static_cast<int>(Separatrix.size()));
+    for (int k = 0; k < Batch.Size(); k++) {
+        const SeparatrixSegment& s = m_CurrentSepSegments[Separatrix[k]];
+        Batch.m_Points[k] = s.m_Endpoint.GetCoordinate();
+        Batch.m_IntervalIndices[k] = s.m_EndpointIntervalIndex;
+        Batch.m_Antipodal[k] = s.EndsOnFrontSideQ();
+    }
+    
+    while (Batch.Size() > 0) {
+        AdvanceOrbits(Batch);
+        int NumLanes = 0;
+        for (int k = 0; k < Batch.Size(); k++) {
+            SeparatrixSegment& s = m_CurrentSepSegments[Separatrix[k]];
+            LeafStep Step = {CirclePoint::FromReducedCoordinate(Batch.m_Points[k]), Batch.m_IntervalIndices[k], Batch.m_IsDivPoint[k] != 0};
+            Lengthen(s, Step);
+            if (!m_FoundSaddleConnectionQ[s.m_Separatrix] && s.m_Depth < BatchDepth) {
+                // Lengthen may have corrected the endpoint, so the lane is reloaded from s
+                Separatrix[NumLanes] = Separatrix[k];
+                Batch.m_Points[NumLanes] = s.m_Endpoint.GetCoordinate();
+                Batch.m_IntervalIndices[NumLanes] = s.m_EndpointIntervalIndex;
+                Batch.m_Antipodal[NumLanes] = s.EndsOnFrontSideQ();
+                NumLanes++;
+            }
+        }
+        Batch.Resize(NumLanes);
+    }
+    
+    if (m_NumThreads > 1) {
+        ThreadPool Pool(m_NumThreads);
+        Pool.Run(m_NumSeparatrices, [&](int SeparatrixIndex){ AdvanceToDepth(SeparatrixIndex, Depth, &Pool); },
+                 std::chrono::seconds(m_StateDatabase == NULL ? 0 : STATE_SAVE_INTERVAL), [this]{ SaveState(*m_StateDatabase); });
+        m_LastStateSave = std::chrono::steady_clock::now();
+        return;
+    }
+    for (int SeparatrixIndex = 0; SeparatrixIndex < m_NumSeparatrices; SeparatrixIndex++) {
+        AdvanceToDepth(SeparatrixIndex, Depth, NULL);
+    }
 }
 
 
 
-void FoliationRP2::Save(const GoodOneSidedCurve& GoodCurve){
-    bool AlreadySaved = false;
-    for (std::list<GoodOneSidedCurve>::iterator it = m_GoodOneSidedCurves.begin(); it != m_GoodOneSidedCurves.end(); it++) {
-        if (*it == GoodCurve) {
-            AlreadySaved = true;
-            break;
+
+// Every so many steps the search is saved if it is due, or, on a ThreadPool, paused for the pool to save it.
+template <typename Precision>
+void FoliationRP2<Precision>::AdvanceToDepth(int SeparatrixIndex, int Depth, ThreadPool* Pool){
+    SeparatrixSegment& s = m_CurrentSepSegments[SeparatrixIndex];
+    for (int NumAdvances = 1; !m_FoundSaddleConnectionQ[SeparatrixIndex] && s.m_Depth < Depth; NumAdvances++) {
+        Advance(s, Depth);
+        if (NumAdvances % 1024 == 0) {
+            if (Pool != NULL) {
+                Pool->PauseIfRequested();
+            } else {
+                SaveStateIfDue();
+            }
         }
     }
-    if (!AlreadySaved) {
+}
+
+
+
+template <typename Precision>
+void FoliationRP2<Precision>::Save(const GoodOneSidedCurve& GoodCurve){
+    if (m_GoodOneSidedCurveKeys.insert(GetKey(GoodCurve)).second) {
         m_GoodOneSidedCurves.push_back(GoodCurve);
     }
 }
 
 
 
-void FoliationRP2::GenerateGoodCurves(int Depth){
+// A right segment of odd depth can only be closed up by a left segment whose depth is 2 more mod 4
+// (AreDepthsGoodForOneSidedCurve), so the left segments are grouped by their depth mod 4, and only the group that
+// matches a right segment is tried with it. Only the pairs with a segment that is new since the last call are tried.
+// The right segments are cut into blocks, which are searched on m_NumThreads threads, and the curves of the blocks are
+// saved in the order of the blocks, which is the order of the pairs. The new curves are sorted and merged into
+// m_GoodOneSidedCurves, the old ones first among equals, which is the order a stable sort of all of them would give.
+template <typename Precision>
+void FoliationRP2<Precision>::GenerateGoodCurves(int Depth){
     GenerateGoodShiftedSeparatrixSegments(Depth);
+    std::vector<CurveSearchBlock> Blocks;
     for (int SeparatrixIndex = 0; SeparatrixIndex < m_NumSeparatrices; SeparatrixIndex++) {
         int IndexOfPair = SeparatrixIndexOfPair(SeparatrixIndex, RIGHT);
-        for (std::list<SeparatrixSegment>::iterator it1 = m_GoodShiftedSeparatrixSegments[SeparatrixIndex][RIGHT].begin();
-             it1 != m_GoodShiftedSeparatrixSegments[SeparatrixIndex][RIGHT].end(); it1++) {
-            for (std::list<SeparatrixSegment>::iterator it2 = m_GoodShiftedSeparatrixSegments[IndexOfPair][LEFT].begin();
-                 it2 != m_GoodShiftedSeparatrixSegments[IndexOfPair][LEFT].end(); it2++) {
-                try {
-                    Save(GetGoodOneSidedCurve(*it2, *it1));
-                }
-                catch (const ExceptionNoObjectFound&) {}
-                catch (const ExceptionFoundSaddleConnection&) {}
+        const AppendOnlyStore<SeparatrixSegment>& LeftSegments = m_GoodShiftedSeparatrixSegments[IndexOfPair][LEFT];
+        int NumRightSegments = m_GoodShiftedSeparatrixSegments[SeparatrixIndex][RIGHT].Size();
+        int NumOldLeftSegments = m_NumPairedGoodSegments[SeparatrixIndex][LEFT];
+        for (int k2 = NumOldLeftSegments; k2 < LeftSegments.Size(); k2++) {
+            m_PairedLeftIndicesByDepth[SeparatrixIndex][LeftSegments[k2].m_Depth % 4].push_back(k2);
+        }
+        int First = NumOldLeftSegments < LeftSegments.Size() ? 0 : m_NumPairedGoodSegments[SeparatrixIndex][RIGHT];
+        for (; First < NumRightSegments; First += CURVE_SEARCH_BLOCK_SIZE) {
+            CurveSearchBlock Block = {SeparatrixIndex, First, std::min(First + CURVE_SEARCH_BLOCK_SIZE, NumRightSegments)};
+            Blocks.push_back(Block);
+        }
+    }
+    
+    std::vector<std::vector<GoodOneSidedCurve>> Curves(Blocks.size());
+    if (m_NumThreads > 1) {
+        ThreadPool Pool(m_NumThreads);
+        Pool.Run(static_cast<int>(Blocks.size()), [&](int k){ FindGoodCurves(Blocks[k], Curves[k]); });
+    } else {
+        for (int k = 0; k < Blocks.size(); k++) {
+            FindGoodCurves(Blocks[k], Curves[k]);
+        }
+    }
+    
+    std::size_t NumOldCurves = m_GoodOneSidedCurves.size();
+    for (int k = 0; k < Curves.size(); k++) {
+        for (int l = 0; l < Curves[k].size(); l++) {
+            Save(Curves[k][l]);
+        }
+    }
+    for (int SeparatrixIndex = 0; SeparatrixIndex < m_NumSeparatrices; SeparatrixIndex++) {
+        m_NumPairedGoodSegments[SeparatrixIndex][RIGHT] = m_GoodShiftedSeparatrixSegments[SeparatrixIndex][RIGHT].Size();
+        m_NumPairedGoodSegments[SeparatrixIndex][LEFT] = m_GoodShiftedSeparatrixSegments[SeparatrixIndexOfPair(SeparatrixIndex, RIGHT)][LEFT].Size();
+    }
+    
+    std::list<GoodOneSidedCurve> NewCurves;
+    NewCurves.splice(NewCurves.end(), m_GoodOneSidedCurves, std::next(m_GoodOneSidedCurves.begin(), NumOldCurves), m_GoodOneSidedCurves.end());
+    NewCurves.sort(Compare);
+    m_GoodOneSidedCurves.merge(NewCurves, Compare);
+}
+
+
+
+
+// The old right segments (those GenerateGoodCurves has tried before) are only tried with the new left segments. Reads
+// the stored segments only, so blocks can be searched at the same time.
+template <typename Precision>
+void FoliationRP2<Precision>::FindGoodCurves(const CurveSearchBlock& Block, std::vector<GoodOneSidedCurve>& Curves) const{
+    const AppendOnlyStore<SeparatrixSegment>& RightSegments = m_GoodShiftedSeparatrixSegments[Block.m_Separatrix][RIGHT];
+    const AppendOnlyStore<SeparatrixSegment>& LeftSegments = m_GoodShiftedSeparatrixSegments[SeparatrixIndexOfPair(Block.m_Separatrix, RIGHT)][LEFT];
+    const std::vector<std::vector<int>>& LeftIndicesByDepth = m_PairedLeftIndicesByDepth[Block.m_Separatrix];
+    int NumOldRightSegments = m_NumPairedGoodSegments[Block.m_Separatrix][RIGHT];
+    int NumOldLeftSegments = m_NumPairedGoodSegments[Block.m_Separatrix][LEFT];
+    Arc ConnectingArc = Arc(CirclePoint());      // set by IsGoodOneSidedCurve
+    for (int k1 = Block.m_FirstRightSegment; k1 < Block.m_LastRightSegment; k1++) {
+        if (RightSegments[k1].m_Depth % 2 == 0) {
+            continue;
+        }
+        const std::vector<int>& LeftIndices = LeftIndicesByDepth[(RightSegments[k1].m_Depth + 2) % 4];
+        int First = k1 < NumOldRightSegments ? static_cast<int>(std::lower_bound(LeftIndices.begin(), LeftIndices.end(), NumOldLeftSegments) - LeftIndices.begin()) : 0;
+        for (int k = First; k < LeftIndices.size(); k++) {
+            const SeparatrixSegment& LeftSegment = LeftSegments[LeftIndices[k]];
+            if (IsGoodOneSidedCurve(LeftSegment, RightSegments[k1], ConnectingArc)) {
+                Curves.push_back(GoodOneSidedCurve(LeftSegment, RightSegments[k1], ConnectingArc));
             }
         }
     }
-    m_GoodOneSidedCurves.sort(Compare);
 }
 
 
@@ -780,12 +1768,118 @@ void FoliationRP2::GenerateGoodCurves(int Depth){
 
 
 
-void FoliationRP2::PrintPseudoAnosovs(int Depth){
+// The connecting arc of a pair lies in an arc around a division point of both segments, so it is not longer than the
+// longest of these arcs of either of them. For each separatrix the left segments of its pair are grouped by their depths
+// mod 4 as in GenerateGoodCurves, and a right segment is tried with the left segments of its group one by one, the
+// bound of the rest of them kept as a suffix maximum. The candidate with the largest bound is always tried first, and a
+// curve is returned once no candidate can give a longer one (or one of the same length earlier in the pair order).
+template <typename Precision>
+FoliationRP2<Precision>::GoodCurveStream::GoodCurveStream(const FoliationRP2& Foliation) :
+    m_Foliation(Foliation),
+    m_LeftIndicesByDepth(Foliation.m_NumSeparatrices, std::vector<std::vector<int>>(4)),
+    m_LeftBounds(Foliation.m_NumSeparatrices, std::vector<std::vector<floating_point_type>>(4))
+{
+    for (int SeparatrixIndex = 0; SeparatrixIndex < Foliation.m_NumSeparatrices; SeparatrixIndex++) {
+        const AppendOnlyStore<SeparatrixSegment>& RightSegments = Foliation.m_GoodShiftedSeparatrixSegments[SeparatrixIndex][RIGHT];
+        const AppendOnlyStore<SeparatrixSegment>& LeftSegments = Foliation.m_GoodShiftedSeparatrixSegments[Foliation.SeparatrixIndexOfPair(SeparatrixIndex, RIGHT)][LEFT];
+        std::vector<std::vector<int>>& LeftIndicesByDepth = m_LeftIndicesByDepth[SeparatrixIndex];
+        std::vector<std::vector<floating_point_type>>& LeftBounds = m_LeftBounds[SeparatrixIndex];
+        for (int k2 = 0; k2 < LeftSegments.Size(); k2++) {
+            LeftIndicesByDepth[LeftSegments[k2].m_Depth % 4].push_back(k2);
+            LeftBounds[LeftSegments[k2].m_Depth % 4].push_back(LeftSegments[k2].m_ArcsAroundDivPoints.GetMaxArcLength());
+        }
+        for (int i = 0; i < 4; i++) {
+            for (int k = static_cast<int>(LeftBounds[i].size()) - 2; k >= 0; k--) {
+                LeftBounds[i][k] = std::max(LeftBounds[i][k], LeftBounds[i][k + 1]);
+            }
+        }
+        for (int k1 = 0; k1 < RightSegments.Size(); k1++) {
+            if (RightSegments[k1].m_Depth % 2 == 1) {
+                Candidate c = {0, RightSegments[k1].m_ArcsAroundDivPoints.GetMaxArcLength(), SeparatrixIndex, k1, 0};
+                Push(c);
+            }
+        }
+    }
+}
+
+
+
+
+// Adds the candidate to m_Candidates with its bound, unless it has no pairs left.
+template <typename Precision>
+void FoliationRP2<Precision>::GoodCurveStream::Push(Candidate c){
+    const std::vector<floating_point_type>& LeftBounds = m_LeftBounds[c.m_Separatrix][(m_Foliation.m_GoodShiftedSeparatrixSegments[c.m_Separatrix][RIGHT][c.m_RightSegment].m_Depth + 2) % 4];
+    if (c.m_LeftPosition >= LeftBounds.size()) {
+        return;
+    }
+    c.m_Bound = std::min(c.m_RightBound, LeftBounds[c.m_LeftPosition]) + 4 * Epsilon<floating_point_type>();    // the lengths are not exact
+    m_Candidates.push_back(c);
+    std::push_heap(m_Candidates.begin(), m_Candidates.end(), HasSmallerBound);
+}
+
+
+
+
+template <typename Precision>
+bool FoliationRP2<Precision>::GoodCurveStream::ComesLater(const FoundCurve& c1, const FoundCurve& c2){
+    if (c1.m_Length != c2.m_Length) {
+        return c1.m_Length < c2.m_Length;
+    }
+    if (c1.m_Separatrix != c2.m_Separatrix) {
+        return c1.m_Separatrix > c2.m_Separatrix;
+    }
+    if (c1.m_RightSegment != c2.m_RightSegment) {
+        return c1.m_RightSegment > c2.m_RightSegment;
+    }
+    return c1.m_LeftPosition > c2.m_LeftPosition;
+}
+
+
+
+
+template <typename Precision>
+const typename FoliationRP2<Precision>::GoodOneSidedCurve* FoliationRP2<Precision>::GoodCurveStream::Next(){
+    Arc ConnectingArc = Arc(CirclePoint());      // set by IsGoodOneSidedCurve
+    while (!m_Candidates.empty() && (m_Found.empty() || !(m_Found.front().m_Length > m_Candidates.front().m_Bound))) {
+        std::pop_heap(m_Candidates.begin(), m_Candidates.end(), HasSmallerBound);
+        Candidate c = m_Candidates.back();
+        m_Candidates.pop_back();
+        
+        const SeparatrixSegment& RightSegment = m_Foliation.m_GoodShiftedSeparatrixSegments[c.m_Separatrix][RIGHT][c.m_RightSegment];
+        int LeftIndex = m_LeftIndicesByDepth[c.m_Separatrix][(RightSegment.m_Depth + 2) % 4][c.m_LeftPosition];
+        const SeparatrixSegment& LeftSegment = m_Foliation.m_GoodShiftedSeparatrixSegments[m_Foliation.SeparatrixIndexOfPair(c.m_Separatrix, RIGHT)][LEFT][LeftIndex];
+        if (m_Foliation.IsGoodOneSidedCurve(LeftSegment, RightSegment, ConnectingArc)) {
+            m_Curves.push_back(GoodOneSidedCurve(LeftSegment, RightSegment, ConnectingArc));
+            FoundCurve f = {ConnectingArc.GetLength(), c.m_Separatrix, c.m_RightSegment, c.m_LeftPosition, static_cast<int>(m_Curves.size()) - 1};
+            m_Found.push_back(f);
+            std::push_heap(m_Found.begin(), m_Found.end(), ComesLater);
+        }
+        c.m_LeftPosition++;
+        Push(c);
+    }
+    if (m_Found.empty()) {
+        return NULL;
+    }
+    std::pop_heap(m_Found.begin(), m_Found.end(), ComesLater);
+    const GoodOneSidedCurve* Curve = &m_Curves[m_Found.back().m_Index];
+    m_Found.pop_back();
+    return Curve;
+}
+
+
+
+
+
+
+// The reference curves are taken from a GoodCurveStream, so the first ones are cut along before the shorter ones are
+// searched for.
+template <typename Precision>
+void FoliationRP2<Precision>::PrintPseudoAnosovs(int Depth, int MaxNumReferenceCurves){
     using namespace std;
-    GenerateGoodCurves(Depth);
-    std::list<GoodOneSidedCurve>::iterator it;
+    GenerateGoodShiftedSeparatrixSegments(Depth);
+    GoodCurveStream Curves(*this);
     int count = 1;
-    for (it = m_GoodOneSidedCurves.begin(); it != m_GoodOneSidedCurves.end() && it->m_SegmentShiftedToLeft.m_Depth <= Depth && it->m_SegmentShiftedToRight.m_Depth <= Depth; ++it) {
+    for (const GoodOneSidedCurve* it = Curves.Next(); it != NULL && it->m_SegmentShiftedToLeft.m_Depth <= Depth && it->m_SegmentShiftedToRight.m_Depth <= Depth; it = Curves.Next()) {
         cout << "***************************************\n";
         cout << "***************************************\n";
         cout << "***************************************\n\n";
@@ -794,6 +1888,9 @@ void FoliationRP2::PrintPseudoAnosovs(int Depth){
        // cout << "We found the foliations with pseudo-anosovs:" << endl << endl;
         FindNewPseudoAnosovs(*it);
         cout << endl;
+        if (count == MaxNumReferenceCurves) {
+            break;
+        }
         count++;
     }
 }
@@ -801,6 +1898,95 @@ void FoliationRP2::PrintPseudoAnosovs(int Depth){
 
 
 
+template <typename Precision>
+void FoliationRP2<Precision>::PrintItinerarySubstitutions(long long Depth){
+    using namespace std;
+    for (int i = 0; i < m_NumSeparatrices; i++) {
+        cout << "SeparatrixIndex: " << i << "\n";
+        try {
+            Substitution ItinerarySubstitution(GetItinerary(i, ITINERARY_PREFIX_LENGTH), 2 * m_NumSeparatrices);
+            AlmostPFMatrix Matrix(ItinerarySubstitution.GetMatrix());
+            cout << "Substitution on " << ItinerarySubstitution.GetNumReturnWords() << " return words";
+            if (Matrix.IsPerronFrobenius()) {
+                cout << ", expansion factor " << Matrix.GetPFEigenvalue();
+            }
+            cout << "\n";
+            cout << "IntervalIntersectionCount at depth " << Depth << ": ";
+            std::vector<long long> Count = GetIntervalIntersectionCount(ItinerarySubstitution, Depth);
+            for (int j = 0; j < m_NumSeparatrices; j++) {
+                cout << Count[j] << " ";
+            }
+            cout << "\n";
+        } catch (const ExceptionNoSubstitutionFound&) {
+            cout << "No substitution found in the first " << ITINERARY_PREFIX_LENGTH << " intersections.\n";
+        }
+        cout << "\n";
+    }
+}
+
+
+
+
+
+// The members of the FoliationFamily are this foliation first, then for each pair of Intervals the foliations with the
+// lengths of the pair multiplied by 1 + MaxRelativeChange, 1 - MaxRelativeChange, 1 + MaxRelativeChange / 2, ...
+// For each member the smallest depth where the itinerary of some separatrix diverges is printed.
+template <typename Precision>
+void FoliationRP2<Precision>::PrintNearbyItineraries(int Depth, floating_point_type MaxRelativeChange){
+    using namespace std;
+    std::vector<floating_point_type> Lengths(m_NumSeparatrices);
+    for (int i = 0; i < m_NumSeparatrices; i++) {
+        Lengths[i] = this->GetLength(i);
+    }
+    std::vector<std::vector<floating_point_type>> LengthVectors(1, Lengths);
+    std::vector<floating_point_type> Changes;
+    for (int i = 0; i < m_NumSeparatrices; i++) {
+        if (m_Pair[i] < i) {
+            continue;
+        }
+        floating_point_type Change = MaxRelativeChange;
+        for (int j = 0; j < NEARBY_ITINERARY_NUM_CHANGES; j++) {
+            for (int Sign = 1; Sign >= -1; Sign -= 2) {
+                std::vector<floating_point_type> NearbyLengths(Lengths);
+                NearbyLengths[i] = NearbyLengths[m_Pair[i]] = Lengths[i] * (1 + Sign * Change);
+                LengthVectors.push_back(NearbyLengths);
+                Changes.push_back(Sign * Change);
+            }
+            Change /= 2;
+        }
+    }
+    FoliationFamily<Precision> Family(LengthVectors, m_Pair);
+    
+    std::vector<int> DivergenceDepths(Family.GetNumMembers(), Depth + 1);
+    for (int i = 0; i < m_NumSeparatrices; i++) {
+        assert(Family.AgreesWithFoliationDisks(i, Depth));
+        std::vector<int> Depths = Family.GetDivergenceDepths(i, Depth);
+        for (int k = 0; k < Family.GetNumMembers(); k++) {
+            DivergenceDepths[k] = min(DivergenceDepths[k], Depths[k]);
+        }
+    }
+    
+    int Member = 1;
+    for (int i = 0; i < m_NumSeparatrices; i++) {
+        if (m_Pair[i] < i) {
+            continue;
+        }
+        cout << "Lengths of the Intervals " << i << " and " << m_Pair[i] << " changed by a factor of\n";
+        for (int j = 0; j < 2 * NEARBY_ITINERARY_NUM_CHANGES; j++, Member++) {
+            cout << "1 " << (Changes[Member - 1] > 0 ? "+ " : "- ") << (Changes[Member - 1] > 0 ? Changes[Member - 1] : -Changes[Member - 1]);
+            if (DivergenceDepths[Member] > Depth) {
+                cout << ": the itineraries agree up to depth " << Depth << "\n";
+            } else {
+                cout << ": the itineraries diverge at depth " << DivergenceDepths[Member] << "\n";
+            }
+        }
+        cout << "\n";
+    }
+}
+
+
+
+
 
 
 
@@ -809,7 +1995,8 @@ void FoliationRP2::PrintPseudoAnosovs(int Depth){
 
 
 /*
-void FoliationRP2::PrintMatrix(const std::vector<std::vector<int>>& Matrix){
+template <typename Precision>
+void FoliationRP2<Precision>::PrintMatrix(const std::vector<std::vector<int>>& Matrix){
     for (int i = 0; i < Matrix.size(); i++) {
         for (int j = 0; j < Matrix.size(); j++) {
             std::cout << Matrix[i][j] << " ";
@@ -829,39 +2016,39 @@ void FoliationRP2::PrintMatrix(const std::vector<std::vector<int>>& Matrix){
 
 
 
-void FoliationRP2::CheckSelfSimilarity(int SeparatrixIndex1, int Depth1, LeftOrRight Side1, int Depth2, RotationData r){
-    try {
-        int SeparatrixIndex2 = SeparatrixIndexOfPair(SeparatrixIndex1, Side1);
-        LeftOrRight Side2 = Opposite(Side1);
-        const SeparatrixSegment& s1 = GetGoodSeparatrixSegment(SeparatrixIndex1, Depth1, Side1);
-        const SeparatrixSegment& s2 = GetGoodSeparatrixSegment(SeparatrixIndex2, Depth2, Side2);
-        const GoodOneSidedCurve& GoodCurve = GetGoodOneSidedCurve(s1, s2);
-        TransitionData td = CutAlongCurve(GoodCurve);
-        td.Rotate(r);
-        if (AreEqual(*this, td.m_NewFoliationDisk, ERROR)) {
-            AlmostPFMatrix SmallMatrix = GetSmallMatrix(td);
-            if (SmallMatrix.IsPerronFrobenius()) {
-                std::cout << "\n\n****** NEW FOLIATION ****** " << std::endl << *this;
-                std::cout << "Cutting curve: " << GoodCurve << std::endl;
-                std::cout << "Pseudo-anosov stretch factor: " << SmallMatrix.GetPFEigenvalue() << std::endl;
-                std::cout << "Corresponding Perron-Frobenius matrix: " << std::endl << GetSmallMatrix(td) << "\n\n";
-            }
+template <typename Precision>
+void FoliationRP2<Precision>::CheckSelfSimilarity(int SeparatrixIndex1, int Depth1, LeftOrRight Side1, int Depth2, RotationData r){
+    int SeparatrixIndex2 = SeparatrixIndexOfPair(SeparatrixIndex1, Side1);
+    LeftOrRight Side2 = Opposite(Side1);
+    const SeparatrixSegment* s1 = GetGoodSeparatrixSegment(SeparatrixIndex1, Depth1, Side1);
+    const SeparatrixSegment* s2 = s1 == NULL ? NULL : GetGoodSeparatrixSegment(SeparatrixIndex2, Depth2, Side2);
+    Arc ConnectingArc = Arc(CirclePoint());
+    if (s2 == NULL || !IsGoodOneSidedCurve(*s1, *s2, ConnectingArc)) {
+        return;
+    }
+    GoodOneSidedCurve GoodCurve(*s1, *s2, ConnectingArc);
+    CutStatus Status;
+    std::unique_ptr<TransitionData> td = CutAlongCurve(GoodCurve, Status);
+    if (td == NULL) {
+        return;
+    }
+    td->Rotate(r);
+    if (AreEqual(*this, td->m_NewFoliationDisk, ERROR)) {
+        AlmostPFMatrix SmallMatrix = GetSmallMatrix(*td);
+        if (SmallMatrix.IsPerronFrobenius()) {
+            std::cout << "\n\n****** NEW FOLIATION ****** " << std::endl << *this;
+            std::cout << "Cutting curve: " << GoodCurve << std::endl;
+            std::cout << "Pseudo-anosov stretch factor: " << SmallMatrix.GetPFEigenvalue() << std::endl;
+            std::cout << "Corresponding Perron-Frobenius matrix: " << std::endl << GetSmallMatrix(*td) << "\n\n";
         }
     }
-    catch (const ExceptionNoObjectFound&) {}
-    catch (const ExceptionFoundSaddleConnection&) {}
 }
 
 
 
 
 
+#define INSTANTIATE_FOLIATION_RP2(Precision) \
+    template class FoliationRP2<Precision>;
 
-
-
-
-
-
-
-
-
+FOR_EACH_PRECISION(INSTANTIATE_FOLIATION_RP2)
@@ -74,6 +74,89 @@
                 However, the SeparatrixSegmentData struct contains which separatrix it is part of (m_Separatrix), 
                 which is the same as the index of the division point which is the first intersection.
  
+    ROUNDING ERRORS:
+ 
+                Every step along a separatrix adds a little rounding error to its endpoint, so the endpoint of a long
+                segment might be so close to a division point that it is not clear on which side of it the real endpoint
+                is, or if it is a saddle connection. Each SeparatrixSegment keeps an upper bound for the error of its
+                endpoint (m_ErrorBound). When the endpoint gets within this bound of a division point, the separatrix
+                is followed in the more precise policy HigherPrecision<Precision> (m_PreciseFoliation) up to the same
+                depth, the endpoint is corrected, and the separatrix goes on in the original precision. Only if the
+                endpoint is near a division point even in the higher precision do we consider it a saddle connection.
+
+                The error bounds of both foliations start from the rounding of their own lengths, so the higher
+                precision only helps if its lengths are more precise, too. A foliation given by lengths that are
+                computed (e.g. the Arnoux-Yoccoz foliations) should get them in both precisions. Otherwise the lengths
+                in the original precision are taken as exact, and m_PreciseFoliation follows that foliation.
+
+    SKIPPING AHEAD:
+
+                As long as the endpoint of a segment is outside of the arcs of its ArcsAroundDivPoints, lengthening
+                the segment only changes m_IntervalIntersectionCount. So from INDUCTION_MIN_DEPTH on, each separatrix
+                keeps the first return maps (see InducedMap) to its arcs around the division points, taken at the
+                times the arcs shrank or the depth grew by INDUCTION_REFINEMENT_RATIO. (The separatrix need not be
+                dense, and then the arcs stop shrinking long before the return times stop growing.) The arcs only
+                shrink, so the segment can jump from one return to these old arcs to the next (Advance). The finest map
+                whose return does not overshoot the requested depth is used, and a single step is taken if the endpoint
+                is too close to the boundary of its piece to tell which piece it is in.
+                
+                The orbits in m_PreciseFoliation skip ahead the same way, using the first return maps to neighbourhoods
+                of the division points (the same for every separatrix). A skipped intersection is outside the
+                neighbourhood, so it is not near a division point.
+
+    THREADS:
+                Past INDUCTION_MIN_DEPTH the separatrices are lengthened independently of each other: each has its
+                own segments, induced maps, checkpoints and precise orbit. So with SetNumThreads they are lengthened
+                on a ThreadPool, each separatrix by one thread, and a thread whose separatrix stops at a saddle
+                connection takes the next one. The only data they share is the precise induced maps, which are built
+                as the orbits need them. An orbit of NumSteps steps always uses the first few of them, the same ones
+                however far the other orbits have refined them (RefinePreciseInducedMaps), so the results are the
+                same bit for bit with any number of threads.
+
+                The pairs of good segments that GenerateGoodCurves tries are cut into blocks of
+                CURVE_SEARCH_BLOCK_SIZE right segments, and the blocks are tried on a ThreadPool too. This only reads
+                the stored segments. Each block keeps its curves in the order of its pairs, and the blocks are saved
+                in order, so the curves are saved in the same order as by one thread.
+
+    ITINERARIES:
+
+                The itinerary of a separatrix is the sequence of the Intervals of its intersections with the Circle
+                from depth 2 on, front side and back side intersections told apart. For pseudo-anosov foliations (the
+                Arnoux-Yoccoz foliations in particular) the itineraries are substitutive, and a Substitution can be
+                detected from the first ITINERARY_PREFIX_LENGTH intersections. The m_IntervalIntersectionCount of a
+                segment of any depth is then the letter count of a prefix of the itinerary, which the substitution
+                gives in logarithmic time without following the separatrix.
+
+                PrintNearbyItineraries changes the lengths of one pair of Intervals at a time by smaller and smaller
+                amounts, and follows the separatrices of all these foliations together (FoliationFamily). The depth up
+                to which their itineraries agree with those of this foliation is how far the good segments and their
+                interval intersection counts stay valid when the lengths are not known exactly.
+
+    COUNT CHECKPOINTS:
+
+                Only the current segment of each separatrix keeps its m_IntervalIntersectionCount up to date. The good
+                segments are stored without it, and instead each separatrix records checkpoints (CountCheckpoint): its
+                endpoint and counts about every COUNT_CHECKPOINT_SPACING steps, and whenever something else that decides the
+                next steps changes (the endpoint is recomputed precisely, a new induced map is built, or the separatrix
+                is advanced towards a different depth). The counts of a stored segment are rebuilt from the last
+                checkpoint before it by repeating the same steps (GetIntervalIntersectionCount), which gives the same
+                endpoints bit for bit. Only the few segments a curve is cut along need their counts.
+
+    SAVED SEARCHES:
+
+                The separatrix segments, the good segments, the count checkpoints, the precise orbits and the induced
+                maps are everything that the search has found, and the rest of the object is computed from the lengths
+                and the pairing. So they are written to an OrbitDatabase (SaveState), and a new object of the same
+                foliation in the same precision reads them back (LoadState) and goes on from the same depths as if it
+                had done the search itself. A file is only used if the pairing, the division points (exactly), the
+                precision and the constants above that decide the steps are all the same.
+
+                A long search saves itself every STATE_SAVE_INTERVAL seconds, if it was given an OrbitDatabase
+                (SetStateDatabase). It can be stopped at any time, and LoadState continues it from the last save. The
+                good segments and the count checkpoints are only appended to, so they go to the log of the file (see
+                OrbitDatabase) and each is written once. What is rewritten at every save is the current segments, the
+                last checkpoints and the induced maps, which hardly grow with the depth.
+ 
  
  
  
@@ -94,9 +177,22 @@
 
 #include "FoliationDisk.h"
 #include "ArcsAroundDivPoints.h"
+#include "InducedMap.h"
+#include "Substitution.h"
+#include "AppendOnlyStore.h"
+#include "RangeMinimumIndex.h"
+#include "OrbitDatabase.h"
+#include "ThreadPool.h"
 #include <list>
 #include <vector>
+#include <deque>
+#include <mutex>
+#include <memory>
+#include <unordered_set>
+#include <functional>
 #include <algorithm>
+#include <type_traits>
+#include <chrono>
 #include "WeighedTree.h"
 #include "AlmostPFMatrix.h"
 
@@ -104,26 +200,71 @@
 
 
 const floating_point_type ERROR = 0.0000001;
+const int INDUCTION_MIN_DEPTH = 1000;       // separatrix segments are lengthened one step at a time up to this depth
+const int INDUCTION_REFINEMENT_RATIO = 2;   // a new induced map is built when the arcs around the division points shrink or the depth grows this much
+const int ITINERARY_PREFIX_LENGTH = 1 << 17;  // the number of intersections a substitution of an itinerary is detected from
+const int NEARBY_ITINERARY_NUM_CHANGES = 10;  // PrintNearbyItineraries halves the change of the lengths this many times
+const int COUNT_CHECKPOINT_SPACING = 1 << 16; // a count checkpoint is saved when the depth passes a multiple of this, 0 keeps the counts in every stored segment
+const int STATE_SAVE_INTERVAL = 60;         // the seconds between two saves of a long search, see SetStateDatabase
+const int CURVE_SEARCH_BLOCK_SIZE = 64;     // the number of right good segments that GenerateGoodCurves tries in one task
+const int COUNT_CHECKPOINT_RECORD = 2;      // the kind of a count checkpoint in the log of a saved state, the kind of a good segment is its side
 
 
-class ExceptionFoundSaddleConnection {};
-class ExceptionNoObjectFound {};
 
 
 
 
 
-class FoliationRP2 : public FoliationDisk {
+template <typename Precision = DefaultPrecision>
+class FoliationRP2 : public FoliationDisk<Precision> {
 public:
+    typedef typename Precision::real_type floating_point_type;
+    typedef ::CirclePoint<Precision> CirclePoint;
+    typedef ::Arc<Precision> Arc;
+    typedef ::ArcsAroundDivPoints<Precision> ArcsAroundDivPoints;
+    typedef ::FoliationDisk<Precision> FoliationDisk;
+    typedef ::AlmostPFMatrix<Precision> AlmostPFMatrix;
+    typedef typename HigherPrecision<Precision>::type PrecisePrecision;
+    typedef typename PrecisePrecision::real_type precise_floating_point_type;
+    
 	FoliationRP2(const WeighedTree& wt);
     FoliationRP2(const std::vector<floating_point_type>& Lengths, const std::vector<int>& Pair);
+    // The same lengths are also given in HigherPrecision<Precision>, for the recomputations (see ROUNDING ERRORS)
+    FoliationRP2(const std::vector<floating_point_type>& Lengths, const std::vector<int>& Pair,
+                 const std::vector<precise_floating_point_type>& PreciseLengths);
     void PrintGoodShiftedSeparatrixSegmentsVerbose(int Depth);
     void PrintGoodShiftedSeparatrixSegmentsConcise(int Depth);
     void PrintGoodCurves(int Depth);
-    void PrintPseudoAnosovs(int Depth);
+    void PrintPseudoAnosovs(int Depth, int MaxNumReferenceCurves = 0);    // cuts along the first MaxNumReferenceCurves curves only, all if 0
+    void PrintItinerarySubstitutions(long long Depth);
+    void PrintNearbyItineraries(int Depth, floating_point_type MaxRelativeChange);  // see ITINERARIES
+    bool SaveState(const OrbitDatabase& Database);
+    bool LoadState(const OrbitDatabase& Database);      // for a new object, false if there is no saved search of the foliation
+    void SetStateDatabase(const OrbitDatabase* Database){ m_StateDatabase = Database; }   // where long searches save themselves, none if NULL
+    void SetNumThreads(int NumThreads){ m_NumThreads = NumThreads; }      // how many separatrices are lengthened at the same time
 
 	
 private:
+    typedef typename FoliationDisk::LeafStep LeafStep;
+    typedef typename FoliationDisk::OrbitBatch OrbitBatch;
+    typedef typename Precision::coordinate_type circle_coordinate_type;
+    typedef ::InducedMap<Precision> InducedMap;
+    typedef ::CirclePoint<PrecisePrecision> PreciseCirclePoint;
+    typedef ::FoliationDisk<PrecisePrecision> PreciseFoliationDisk;
+    typedef ::Arc<PrecisePrecision> PreciseArc;
+    typedef ::InducedMap<PrecisePrecision> PreciseInducedMap;
+    static const bool CAN_ESCALATE = !std::is_same<Precision, PrecisePrecision>::value;
+    using FoliationDisk::m_NumSeparatrices;
+    using FoliationDisk::m_DivPoints;
+    using FoliationDisk::m_Pair;
+    using FoliationDisk::IncreaseIndex;
+    using FoliationDisk::DecreaseIndex;
+    using FoliationDisk::SeparatrixIndexOfPair;
+    using FoliationDisk::WhichIntervalContains;
+    using FoliationDisk::NextIntersection;
+    using FoliationDisk::AdvanceOrbits;
+    using FoliationDisk::Locate;
+    using FoliationDisk::DistanceFromDivPoints;
 
 //-------------------//
 // SeparatrixSegment //
@@ -133,8 +274,10 @@ private:
         int m_Separatrix;       // which separatrix the segment belongs to
         int m_Depth;            // the depth of the segment
         CirclePoint m_Endpoint;
+        int m_EndpointIntervalIndex;    // the index of the Interval containing m_Endpoint
+        floating_point_type m_ErrorBound;   // an upper bound for the distance of m_Endpoint from the exact endpoint
         ArcsAroundDivPoints m_ArcsAroundDivPoints;  // the ArcsAroundDivPoints data induced by the segment
-        std::vector<int> m_IntervalIntersectionCount;           // counts how many times each Interval intersects the segment
+        SharedVector<int> m_IntervalIntersectionCount;          // counts how many times each Interval intersects the segment
         LeftOrRight m_Side;
 
         SeparatrixSegment(const std::vector<CirclePoint>& DivPoints);
@@ -152,13 +295,81 @@ private:
     void ShiftToSide(SeparatrixSegment& s, LeftOrRight Side);
     void AddToGoodSegmentsIfGood(const SeparatrixSegment& s);
     void Lengthen(SeparatrixSegment& s);
-    SeparatrixSegment& GetFirstIntersection(int SeparatrixIndex, const Arc& arc, LeftOrRight ReturnSide);
-    SeparatrixSegment& GetGoodSeparatrixSegment(int SeparatrixIndex, int Depth, LeftOrRight Side);
-    SeparatrixSegment& GetGoodSeparatrixSegment(SeparatrixSegment& s, LeftOrRight EndpointShiftedTo);
-    friend std::ostream& operator<<(std::ostream& Out, const SeparatrixSegment& data);
+    void Lengthen(SeparatrixSegment& s, const LeafStep& Step);   // the same, when the next intersection is already known
+    void Advance(SeparatrixSegment& s, int MaxDepth);   // skips to the next return near the division points, if possible
+    void AdvanceToDepth(int SeparatrixIndex, int Depth, ThreadPool* Pool);     // Pool is the one running this, NULL if none
+    void MoveEndpoint(SeparatrixSegment& s, const LeafStep& Step, int NumSteps);
+    void UpdateInducedMaps(const SeparatrixSegment& s);
+    const typename InducedMap::Piece* FindReturn(int SeparatrixIndex, int NumMaps, const CirclePoint& Endpoint, bool FrontSide,
+                                                 int MaxSteps, floating_point_type ErrorBound, int& Level) const;
+    bool RecomputePrecisely(SeparatrixSegment& s);
+    std::vector<int> GetItinerary(int SeparatrixIndex, int Length);
+    std::vector<int> GetIntervalIntersectionCount(const SeparatrixSegment& s);
+    std::vector<long long> GetIntervalIntersectionCount(const Substitution& ItinerarySubstitution, long long Depth);
+    SeparatrixSegment* GetFirstIntersection(int SeparatrixIndex, const Arc& arc, LeftOrRight ReturnSide);     // NULL at a saddle connection
+    int FindFirstEndpointInArc(int SeparatrixIndex, LeftOrRight Side, const Arc& arc) const;   // the index of the good segment, INT_MAX if there is none
+    SeparatrixSegment* GetGoodSeparatrixSegment(int SeparatrixIndex, int Depth, LeftOrRight Side);       // NULL if it is not good
+    SeparatrixSegment* GetGoodSeparatrixSegment(SeparatrixSegment& s, LeftOrRight EndpointShiftedTo);
+    static int FindDepth(const AppendOnlyStore<SeparatrixSegment>& Segments, int Depth);   // the index of the first segment not shorter than Depth
+    static std::ostream& Print(std::ostream& Out, const SeparatrixSegment& data);
+    friend std::ostream& operator<<(std::ostream& Out, const SeparatrixSegment& data){ return Print(Out, data); }
 
     
     
+//--------------//
+// PreciseOrbit //
+//--------------//
+    
+    // The endpoint of a separatrix segment in m_PreciseFoliation. It is only moved forward when the segment
+    // needs it, see RecomputePrecisely.
+    struct PreciseOrbit{
+        int m_Depth;
+        PreciseCirclePoint m_Endpoint;
+        int m_EndpointIntervalIndex;
+        precise_floating_point_type m_ErrorBound;
+    };
+    
+    bool AdvancePrecisely(PreciseOrbit& Orbit, int MaxDepth, const std::vector<const PreciseInducedMap*>& Maps,
+                          const std::vector<precise_floating_point_type>& Radius);
+    void RefinePreciseInducedMaps(int NumSteps, std::vector<const PreciseInducedMap*>& Maps, std::vector<precise_floating_point_type>& Radius);
+    
+    
+    
+//-----------------//
+// CountCheckpoint //
+//-----------------//
+    
+    // The current segment of a separatrix at some depth, with what Advance needs to repeat the next steps.
+    struct CountCheckpoint{
+        int m_Depth;
+        CirclePoint m_Endpoint;
+        int m_EndpointIntervalIndex;
+        floating_point_type m_ErrorBound;
+        std::vector<int> m_IntervalIntersectionCount;
+        int m_NumInducedMaps;   // how many induced maps of the separatrix Advance uses
+        int m_MaxDepth;         // the MaxDepth of Advance
+    };
+    
+    void SaveCountCheckpoint(const SeparatrixSegment& s, int MaxDepth);
+    
+    
+    
+//----------------//
+// SAVED SEARCHES //
+//----------------//
+    
+    std::string GetStateName() const;
+    static std::vector<int> GetStateConstants();
+    void WriteStateKey(StateWriter& Writer) const;
+    bool IsStateKey(StateReader& Reader) const;
+    static void Write(StateWriter& Writer, const SeparatrixSegment& s);
+    static void Write(StateWriter& Writer, const CountCheckpoint& c);
+    void Read(StateReader& Reader, SeparatrixSegment& s) const;
+    void Read(StateReader& Reader, CountCheckpoint& c) const;
+    void SaveStateIfDue();
+    
+    
+    
 //--------------//
 // RotationData //
 //--------------//
@@ -181,8 +392,8 @@ private:
         
         inline int GetEntry(int x, int y) const { return m_Matrix[x][y]; }
         inline void UpdateRow(int Row, const std::vector<int>& AmountOfChange, int HowManyTimes);
-        inline void UpdateTransitionMatrix(const SeparatrixSegment& s, int SmallIntervalIndex);
-        inline void UpdateTransitionMatrix(const SeparatrixSegment& s, const std::vector<int>& AmountOfChange);
+        inline void UpdateTransitionMatrix(const std::vector<int>& IntervalIntersectionCount, int SmallIntervalIndex);
+        inline void UpdateTransitionMatrix(const std::vector<int>& IntervalIntersectionCount, const std::vector<int>& AmountOfChange);
         inline void Rotate();
         inline void Reflect();
     private:
@@ -228,15 +439,99 @@ private:
 // GoodOneSidedCurve  (RELATED FUNCTIONS) //
 //----------------------------------------//
     
-    bool AreDepthsGoodForOneSidedCurve(int Depth1, int Depth2);
-    Arc GetClosingArcIfGoodOneSidedCurve(const SeparatrixSegment& Segment1, const SeparatrixSegment& Segment2);
-    GoodOneSidedCurve GetGoodOneSidedCurve(const SeparatrixSegment& SegmentShiftedToLeft, const SeparatrixSegment& SegmentShiftedToRight);
-    TransitionData CutAlongCurve(const GoodOneSidedCurve& GoodCurve);
+    bool AreDepthsGoodForOneSidedCurve(int Depth1, int Depth2) const;
+    bool GetClosingArcIfGoodOneSidedCurve(const SeparatrixSegment& Segment1, const SeparatrixSegment& Segment2, Arc& ClosingArc) const;
+    bool IsGoodOneSidedCurve(const SeparatrixSegment& SegmentShiftedToLeft, const SeparatrixSegment& SegmentShiftedToRight, Arc& ConnectingArc) const;
+    enum CutStatus{
+        CUT_DONE,
+        CUT_SADDLE_CONNECTION,      // a separatrix reaches a saddle connection before it crosses the curve
+        CUT_SEGMENT_NOT_GOOD        // a segment needed for the matrix is not good
+    };
+    std::unique_ptr<TransitionData> CutAlongCurve(const GoodOneSidedCurve& GoodCurve, CutStatus& Status);   // NULL unless Status is CUT_DONE
     void Save(const GoodOneSidedCurve& GoodCurve);
-    friend bool operator==(const GoodOneSidedCurve& c1, const GoodOneSidedCurve& c2);
-    friend std::ostream& operator<<(std::ostream& Out, const GoodOneSidedCurve& data);
+    friend bool operator==(const GoodOneSidedCurve& c1, const GoodOneSidedCurve& c2){
+        return c1.m_SegmentShiftedToLeft.m_Separatrix == c2.m_SegmentShiftedToLeft.m_Separatrix &&
+        c1.m_SegmentShiftedToRight.m_Separatrix == c2.m_SegmentShiftedToRight.m_Separatrix &&
+        c1.m_SegmentShiftedToLeft.m_Depth == c2.m_SegmentShiftedToLeft.m_Depth &&
+        c1.m_SegmentShiftedToRight.m_Depth == c2.m_SegmentShiftedToRight.m_Depth;
+    }
+    static std::ostream& Print(std::ostream& Out, const GoodOneSidedCurve& data);
+    friend std::ostream& operator<<(std::ostream& Out, const GoodOneSidedCurve& data){ return Print(Out, data); }
     static bool Compare(const GoodOneSidedCurve& c1, const GoodOneSidedCurve& c2);
     
+    // Some right good segments of a separatrix, to be tried with the left good segments of its pair.
+    struct CurveSearchBlock{
+        int m_Separatrix;
+        int m_FirstRightSegment;
+        int m_LastRightSegment;     // the one after the last
+    };
+    void FindGoodCurves(const CurveSearchBlock& Block, std::vector<GoodOneSidedCurve>& Curves) const;
+    
+    
+    
+//-----------------//
+// GoodCurveStream //
+//-----------------//
+    
+    // The good curves of the stored segments one by one, in the order of Compare, the ones of equal length in the
+    // order of their pairs in GenerateGoodCurves. Only as many pairs are tried as needed for the next curve.
+    class GoodCurveStream{
+    public:
+        GoodCurveStream(const FoliationRP2& Foliation);
+        const GoodOneSidedCurve* Next();        // NULL if there are no more, valid as long as the stream
+        
+    private:
+        // The pairs of a right segment with the left segments of its group from m_LeftPosition on.
+        struct Candidate{
+            floating_point_type m_Bound;        // none of these pairs has a longer connecting arc
+            floating_point_type m_RightBound;   // the longest arc around the division points of the right segment
+            int m_Separatrix;
+            int m_RightSegment;
+            int m_LeftPosition;
+        };
+        struct FoundCurve{
+            floating_point_type m_Length;
+            int m_Separatrix;
+            int m_RightSegment;
+            int m_LeftPosition;
+            int m_Index;        // in m_Curves
+        };
+        static bool HasSmallerBound(const Candidate& c1, const Candidate& c2){ return c1.m_Bound < c2.m_Bound; }
+        static bool ComesLater(const FoundCurve& c1, const FoundCurve& c2);
+        void Push(Candidate c);
+        
+        const FoliationRP2& m_Foliation;
+        std::vector<std::vector<std::vector<int>>> m_LeftIndicesByDepth;    // for each separatrix, as in GenerateGoodCurves
+        std::vector<std::vector<std::vector<floating_point_type>>> m_LeftBounds;    // the longest arc of the left segments of a group from each position on
+        std::vector<Candidate> m_Candidates;    // a heap, the largest bound first
+        std::vector<FoundCurve> m_Found;        // a heap, the first in the order above first
+        std::deque<GoodOneSidedCurve> m_Curves;
+    };
+    
+    // What operator== compares, so a curve is found among the saved ones by hashing.
+    struct CurveKey{
+        int m_SeparatrixShiftedToLeft;
+        int m_SeparatrixShiftedToRight;
+        int m_DepthShiftedToLeft;
+        int m_DepthShiftedToRight;
+        
+        bool operator==(const CurveKey& k) const{
+            return m_SeparatrixShiftedToLeft == k.m_SeparatrixShiftedToLeft && m_SeparatrixShiftedToRight == k.m_SeparatrixShiftedToRight &&
+                   m_DepthShiftedToLeft == k.m_DepthShiftedToLeft && m_DepthShiftedToRight == k.m_DepthShiftedToRight;
+        }
+    };
+    struct CurveKeyHash{
+        std::size_t operator()(const CurveKey& k) const{
+            return std::hash<long long>()((static_cast<long long>(k.m_DepthShiftedToLeft) << 32 ^ k.m_DepthShiftedToRight) * 31 +
+                                          k.m_SeparatrixShiftedToLeft * 65537 + k.m_SeparatrixShiftedToRight);
+        }
+    };
+    static CurveKey GetKey(const GoodOneSidedCurve& c){
+        CurveKey k = {c.m_SegmentShiftedToLeft.m_Separatrix, c.m_SegmentShiftedToRight.m_Separatrix,
+                      c.m_SegmentShiftedToLeft.m_Depth, c.m_SegmentShiftedToRight.m_Depth};
+        return k;
+    }
+    
     
     
 
@@ -244,9 +539,37 @@ private:
 // MEMBER VARIABLES
     
     std::vector<SeparatrixSegment> m_CurrentSepSegments; // stores information about the current separatrix segment
-    std::vector<std::vector<std::list<SeparatrixSegment>>> m_GoodShiftedSeparatrixSegments; // stores good separating segments
+    std::vector<std::vector<AppendOnlyStore<SeparatrixSegment>>> m_GoodShiftedSeparatrixSegments; // stores good separating segments, in the order of their depth
+    std::vector<std::vector<RangeMinimumIndex<circle_coordinate_type>>> m_GoodEndpointIndices;  // the endpoints of the good segments, with their index
+    std::vector<std::vector<CountCheckpoint>> m_CountCheckpoints;   // for each separatrix, in the order of their depth
     std::list<GoodOneSidedCurve> m_GoodOneSidedCurves;
-    std::vector<char> m_FoundSaddleConnectionQ; // for each separatrix, shows if we have already found a saddle connection
+    std::unordered_set<CurveKey, CurveKeyHash> m_GoodOneSidedCurveKeys;    // the keys of m_GoodOneSidedCurves
+    std::vector<std::vector<int>> m_NumPairedGoodSegments;     // for each separatrix, how many of its right good segments (RIGHT) and of the left good
+                                                               // segments of its pair (LEFT) GenerateGoodCurves has tried
+    std::vector<std::vector<std::vector<int>>> m_PairedLeftIndicesByDepth;  // for each separatrix, the indices of those left segments for each depth mod 4
+    std::vector<char> m_FoundSaddleConnectionQ; // for each separatrix, shows if we have already found a saddle connection (char, since the flags
+                                                // of different separatrices are set by different threads, and std::vector<bool> packs them into shared bytes)
+    PreciseFoliationDisk m_PreciseFoliation;    // the same foliation in HigherPrecision<Precision>
+    std::vector<PreciseOrbit> m_PreciseOrbits;  // for each separatrix, how far it has been followed in m_PreciseFoliation
+    floating_point_type m_DivPointError;    // an upper bound for the distance of a division point from the exact one
+    floating_point_type m_StepError;        // how much the error of an endpoint can grow in one step
+    precise_floating_point_type m_PreciseDivPointError;     // the same two in m_PreciseFoliation
+    precise_floating_point_type m_PreciseStepError;
+    InducedMap m_StepMap;       // the step map of the separatrices, from which the induced maps are built
+    std::vector<std::vector<InducedMap>> m_InducedMaps;     // for each separatrix, the first return maps to the arcs around the division points, coarsest first
+    std::vector<floating_point_type> m_NextInductionMeasure;   // for each separatrix, the size of the arcs when the next induced map is built
+    std::vector<int> m_NextInductionDepth;                     // for each separatrix, the depth when the next induced map is built at the latest
+    PreciseInducedMap m_PreciseStepMap;
+    std::deque<PreciseInducedMap> m_PreciseInducedMaps;     // the first return maps of m_PreciseFoliation to smaller and smaller neighbourhoods of the division points
+    std::vector<precise_floating_point_type> m_PreciseInductionRadius;  // the radius of these neighbourhoods
+    bool m_PreciseInductionFailed;
+    std::mutex m_PreciseInductionMutex;     // guards the three above, which are shared by the separatrices
+    int m_NumThreads;
+    const OrbitDatabase* m_StateDatabase;   // where long searches are saved, see SetStateDatabase
+    std::chrono::steady_clock::time_point m_LastStateSave;
+    std::vector<std::vector<int>> m_NumSavedGoodSegments;  // for each separatrix and side, how many good segments are in the log of the saved state
+    std::vector<int> m_NumSavedCountCheckpoints;        // for each separatrix, how many count checkpoints are in that log
+    long long m_SavedLogSize;
 
 // INITIALIZING
     
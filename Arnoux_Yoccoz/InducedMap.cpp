@@ -0,0 +1,344 @@
+/*******************************************************************************
+ *  CLASS NAME:	InducedMap
+ *  AUTHOR:		Balazs Strenner
+ *				Copyright 2013 UW-Madison. All rights reserved.
+ *
+ ******************************************************************************/
+
+
+#include "InducedMap.h"
+#include <algorithm>
+#include <climits>
+
+
+
+
+// The step map: on the front side the Intervals are moved to the antipodal side, on the back side they are flipped
+// along the leaves, exactly as in FoliationDisk::NextIntersection.
+template <typename Precision>
+InducedMap<Precision>::InducedMap(const FoliationDisk& fd) :
+    m_Measure(1),
+    m_NumIntervals(fd.GetNumSeparatrices())
+{
+    for (int Side = 0; Side < 2; Side++) {
+        for (int i = 0; i < m_NumIntervals; i++) {
+            const circle_coordinate_type& End = fd.GetDivPoint(i < m_NumIntervals - 1 ? i + 1 : 0).GetCoordinate();
+            Piece p;
+            p.m_Begin = fd.GetDivPoint(i).GetCoordinate();
+            p.m_Length = Coordinate::Reduce(End - p.m_Begin);
+            p.m_FrontSide = Side == 1;
+            p.m_Reverses = Side == 0;
+            p.m_Shift = p.m_FrontSide ? Coordinate::Half() : fd.GetDivPoint(fd.GetPair(i)).GetCoordinate() + End;
+            p.m_ReturnTime = 1;
+            p.m_IntervalIntersectionCount.assign(m_NumIntervals, 0);
+            p.m_IntervalIntersectionCount[i] = 1;
+            m_Pieces[Side].push_back(p);
+        }
+    }
+}
+
+
+
+
+// Computes the first return map to Domain from the first return map to a larger set. Throws ExceptionInductionFailed
+// if the computation gets too long, or if a fragment runs into a hole of Coarser that is not due to rounding. In these
+// cases Coarser can still be used.
+template <typename Precision>
+InducedMap<Precision>::InducedMap(const InducedMap& Coarser, const std::vector<Arc>& Domain) :
+    m_Measure(0),
+    m_NumIntervals(Coarser.m_NumIntervals)
+{
+    const circle_coordinate_type Zero = Coordinate::FromReal(floating_point_type(0));
+    const circle_coordinate_type Tolerance = Coordinate::FromReal(INDUCTION_TOLERANCE * Coordinate::template RoundingError<floating_point_type>());
+
+    // The arcs of Domain, cut in two if they go around 0. The same arc can be around more division points, and the arcs
+    // can overlap.
+    std::vector<Piece> Components;
+    for (int i = 0; i < Domain.size(); i++) {
+        if (Domain[i].GetLength() == 1) {
+            throw ExceptionInductionFailed();
+        }
+        Piece c = Piece();
+        c.m_Shift = Zero;
+        c.m_Begin = Domain[i].GetLeftEndpoint().GetCoordinate();
+        const circle_coordinate_type& End = Domain[i].GetRightEndpoint().GetCoordinate();
+        if (End < c.m_Begin) {
+            c.m_Length = Coordinate::Reduce(Zero - c.m_Begin);
+            Components.push_back(c);
+            c.m_Begin = Zero;
+        }
+        c.m_Length = End - c.m_Begin;
+        if (Tolerance < c.m_Length) {
+            Components.push_back(c);
+        }
+    }
+    std::sort(Components.begin(), Components.end(), IsBefore);
+    int NumComponents = 0;
+    for (int i = 0; i < Components.size(); i++) {
+        if (NumComponents > 0 && !(Components[NumComponents - 1].m_Length < Components[i].m_Begin - Components[NumComponents - 1].m_Begin)) {
+            // overlapping arcs are merged
+            Piece& Last = Components[NumComponents - 1];
+            circle_coordinate_type Length = Components[i].m_Begin - Last.m_Begin + Components[i].m_Length;
+            if (Last.m_Length < Length) {
+                Last.m_Length = Length;
+            }
+        } else {
+            Components[NumComponents++] = Components[i];
+        }
+    }
+    Components.resize(NumComponents);
+    for (int i = 0; i < NumComponents; i++) {
+        m_Measure += Coordinate::template ToReal<floating_point_type>(Components[i].m_Length);
+    }
+    if (NumComponents == 0) {
+        throw ExceptionInductionFailed();
+    }
+
+    // Each fragment needs about as many moves as the ratio of the two domains.
+    const double MaxWork = INDUCTION_WORK_FACTOR * (static_cast<double>(Coarser.m_Measure / m_Measure) + 1) *
+                           (Coarser.GetNumPieces() + 2 * NumComponents);
+
+    std::vector<Fragment> Stack;
+    for (int Side = 0; Side < 2; Side++) {
+        for (int i = 0; i < NumComponents; i++) {
+            Fragment f;
+            f.m_Piece.m_Begin = Components[i].m_Begin;
+            f.m_Piece.m_Length = Components[i].m_Length;
+            f.m_Piece.m_FrontSide = Side == 1;
+            f.m_Piece.m_Reverses = false;
+            f.m_Piece.m_Shift = Zero;
+            f.m_Piece.m_ReturnTime = 0;
+            f.m_Piece.m_IntervalIntersectionCount.assign(m_NumIntervals, 0);
+            f.m_OnFrontSide = f.m_Piece.m_FrontSide;
+            Stack.push_back(f);
+        }
+    }
+
+    double Work = 0;
+    while (!Stack.empty()) {
+        Fragment f = Stack.back();
+        Stack.pop_back();
+        if (++Work > MaxWork) {
+            throw ExceptionInductionFailed();
+        }
+        if (!(Tolerance < f.m_Piece.m_Length)) {
+            continue;
+        }
+
+        // If the fragment has moved, the part of it that is back in Domain is a piece of the new map.
+        circle_coordinate_type Distance;
+        if (f.m_Piece.m_ReturnTime > 0) {
+            const Piece* c = FindNear(Components, ImageBegin(f), Tolerance, Distance);
+            if (Distance < f.m_Piece.m_Length) {
+                Split(f, Distance, Stack, Tolerance);
+            }
+            if (c != NULL) {
+                if (Tolerance < f.m_Piece.m_Length) {
+                    m_Pieces[f.m_Piece.m_FrontSide].push_back(f.m_Piece);
+                }
+                continue;
+            }
+        }
+
+        // The rest is moved by the coarser map, one of its pieces at a time. The images of the coarser map are in its
+        // domain, up to rounding and holes shorter than Tolerance.
+        const Piece* p = FindNear(Coarser.m_Pieces[f.m_OnFrontSide], ImageBegin(f), Tolerance, Distance);
+        if (p == NULL) {
+            throw ExceptionInductionFailed();
+        }
+        if (Distance < f.m_Piece.m_Length) {
+            Split(f, Distance, Stack, Tolerance);
+        }
+        if (p->m_ReturnTime > INT_MAX / 2 - f.m_Piece.m_ReturnTime) {
+            throw ExceptionInductionFailed();
+        }
+        Compose(f, *p);
+        Stack.push_back(f);
+    }
+
+    for (int Side = 0; Side < 2; Side++) {
+        std::sort(m_Pieces[Side].begin(), m_Pieces[Side].end(), IsBefore);
+    }
+}
+
+
+
+
+
+template <typename Precision>
+InducedMap<Precision>::InducedMap(StateReader& Reader){
+    Reader.Read(m_Measure);
+    Reader.Read(m_NumIntervals);
+    for (int Side = 0; Side < 2; Side++) {
+        int NumPieces = Reader.Read<int>();
+        if (NumPieces < 0) {
+            throw ExceptionCorruptState();
+        }
+        m_Pieces[Side].resize(NumPieces);
+        for (int k = 0; k < m_Pieces[Side].size(); k++) {
+            Piece& p = m_Pieces[Side][k];
+            Reader.Read(p.m_Begin);
+            Reader.Read(p.m_Length);
+            Reader.Read(p.m_FrontSide);
+            Reader.Read(p.m_Reverses);
+            Reader.Read(p.m_Shift);
+            Reader.Read(p.m_ReturnTime);
+            Reader.Read(p.m_IntervalIntersectionCount);
+            if (p.m_IntervalIntersectionCount.size() != m_NumIntervals) {
+                throw ExceptionCorruptState();
+            }
+        }
+    }
+}
+
+
+
+
+template <typename Precision>
+void InducedMap<Precision>::Write(StateWriter& Writer) const{
+    Writer.Write(m_Measure);
+    Writer.Write(m_NumIntervals);
+    for (int Side = 0; Side < 2; Side++) {
+        Writer.Write(static_cast<int>(m_Pieces[Side].size()));
+        for (int k = 0; k < m_Pieces[Side].size(); k++) {
+            const Piece& p = m_Pieces[Side][k];
+            Writer.Write(p.m_Begin);
+            Writer.Write(p.m_Length);
+            Writer.Write(p.m_FrontSide);
+            Writer.Write(p.m_Reverses);
+            Writer.Write(p.m_Shift);
+            Writer.Write(p.m_ReturnTime);
+            Writer.Write(p.m_IntervalIntersectionCount);
+        }
+    }
+}
+
+
+
+
+template <typename Precision>
+const typename InducedMap<Precision>::Piece* InducedMap<Precision>::FindPiece(const circle_coordinate_type& x, bool FrontSide) const{
+    return FindIn(m_Pieces[FrontSide], x);
+}
+
+
+
+
+template <typename Precision>
+typename InducedMap<Precision>::circle_coordinate_type InducedMap<Precision>::Apply(const Piece& p, const circle_coordinate_type& x) const{
+    return p.m_Reverses ? Coordinate::Reduce(Coordinate::Reduce(-x) + p.m_Shift) : Coordinate::Reduce(x + p.m_Shift);
+}
+
+
+
+
+// The distance of x from the nearer endpoint of p. x must be in p.
+template <typename Precision>
+typename InducedMap<Precision>::floating_point_type InducedMap<Precision>::DistanceFromBoundary(const Piece& p, const circle_coordinate_type& x) const{
+    floating_point_type FromBegin = Coordinate::template DistanceToTheRight<floating_point_type>(p.m_Begin, x);
+    floating_point_type ToEnd = Coordinate::template DistanceToTheRight<floating_point_type>(x, p.m_Begin + p.m_Length);
+    return FromBegin < ToEnd ? FromBegin : ToEnd;
+}
+
+
+
+
+// The piece of Pieces (sorted, and none of them going around 0) containing x, or NULL.
+template <typename Precision>
+const typename InducedMap<Precision>::Piece* InducedMap<Precision>::FindIn(const std::vector<Piece>& Pieces, const circle_coordinate_type& x){
+    typename std::vector<Piece>::const_iterator it = std::upper_bound(Pieces.begin(), Pieces.end(), x, BeginsAfter);
+    if (it == Pieces.begin()) {
+        return NULL;
+    }
+    --it;
+    return x - it->m_Begin < it->m_Length ? &*it : NULL;
+}
+
+
+
+
+// The same as FindIn, but a piece beginning at most Tolerance to the right of x is taken to contain x, since x might be
+// off by rounding. For the same reason, x is not taken to be in a piece that ends at most Tolerance to the right of it.
+// Distance is set to the distance from x to the end of the piece, or if there is no piece, to the beginning of the next
+// one. After the last piece the next one is the first piece, around 0. This assumes that no piece goes around 0, which
+// holds because the pieces lie in Intervals and division point 0 is at coordinate 0 (see FoliationDisk::Init).
+template <typename Precision>
+const typename InducedMap<Precision>::Piece* InducedMap<Precision>::FindNear(const std::vector<Piece>& Pieces, const circle_coordinate_type& x,
+                                                                            const circle_coordinate_type& Tolerance, circle_coordinate_type& Distance){
+    typename std::vector<Piece>::const_iterator it = std::upper_bound(Pieces.begin(), Pieces.end(), x, BeginsAfter);
+    if (it != Pieces.begin()) {
+        circle_coordinate_type Offset = x - (it - 1)->m_Begin;
+        if (Offset < (it - 1)->m_Length) {
+            Distance = (it - 1)->m_Length - Offset;
+            if (Tolerance < Distance) {
+                return &*(it - 1);
+            }
+        }
+    }
+    const Piece& Next = it == Pieces.end() ? Pieces.front() : *it;
+    Distance = Coordinate::Reduce(Next.m_Begin - x);
+    if (Tolerance < Distance) {
+        return NULL;
+    }
+    Distance = Distance + Next.m_Length;
+    return &Next;
+}
+
+
+
+
+// The left endpoint of the current image of the fragment.
+template <typename Precision>
+typename InducedMap<Precision>::circle_coordinate_type InducedMap<Precision>::ImageBegin(const Fragment& f){
+    const Piece& p = f.m_Piece;
+    return p.m_Reverses ? Coordinate::Reduce(p.m_Shift - Coordinate::Reduce(p.m_Begin + p.m_Length)) : Coordinate::Reduce(p.m_Begin + p.m_Shift);
+}
+
+
+
+
+// Keeps the part of f whose image is the first ImageLength of the image of f, and pushes the rest to Stack
+// (unless it is too short to keep).
+template <typename Precision>
+void InducedMap<Precision>::Split(Fragment& f, const circle_coordinate_type& ImageLength, std::vector<Fragment>& Stack,
+                                  const circle_coordinate_type& Tolerance){
+    Fragment Rest = f;
+    Rest.m_Piece.m_Length = f.m_Piece.m_Length - ImageLength;
+    if (f.m_Piece.m_Reverses) {
+        f.m_Piece.m_Begin = Coordinate::Reduce(f.m_Piece.m_Begin + Rest.m_Piece.m_Length);
+    } else {
+        Rest.m_Piece.m_Begin = Coordinate::Reduce(f.m_Piece.m_Begin + ImageLength);
+    }
+    f.m_Piece.m_Length = ImageLength;
+    if (Tolerance < Rest.m_Piece.m_Length) {
+        Stack.push_back(Rest);
+    }
+}
+
+
+
+
+// Moves the image of f by p.
+template <typename Precision>
+void InducedMap<Precision>::Compose(Fragment& f, const Piece& p){
+    Piece& q = f.m_Piece;
+    q.m_Shift = p.m_Reverses ? Coordinate::Reduce(Coordinate::Reduce(-q.m_Shift) + p.m_Shift) : Coordinate::Reduce(q.m_Shift + p.m_Shift);
+    q.m_Reverses = q.m_Reverses != p.m_Reverses;
+    q.m_ReturnTime += p.m_ReturnTime;
+    for (int i = 0; i < q.m_IntervalIntersectionCount.size(); i++) {
+        q.m_IntervalIntersectionCount[i] += p.m_IntervalIntersectionCount[i];
+    }
+    if (p.m_ReturnTime % 2 == 1) {
+        f.m_OnFrontSide = !f.m_OnFrontSide;
+    }
+}
+
+
+
+
+
+
+#define INSTANTIATE_INDUCED_MAP(Precision) \
+    template class InducedMap<Precision>;
+
+FOR_EACH_PRECISION(INSTANTIATE_INDUCED_MAP)
@@ -0,0 +1,112 @@
+/*******************************************************************************
+ *  CLASS NAME:	InducedMap
+ *  AUTHOR:		Balazs Strenner
+ *				Copyright 2013 UW-Madison. All rights reserved.
+ *
+ *	DESCRIPTION: The first return map of the leaves of a FoliationDisk on RP^2 to a union of arcs of the Circle.
+
+    THE STEP MAP:
+                A separatrix of FoliationRP2 hits the Circle again and again, alternately on the front side (after which
+                it continues at the antipodal point) and on the back side (after which it follows the leaf inside the
+                disk). So the step map T acts on two copies of the Circle, the front side and the back side, and maps
+                each to the other. On each Interval between the division points T is an isometry: a translation by 1/2
+                on the front side, and x -> m_TempForFollowTheLeaf[i] - x on the back side.
+
+    INDUCED MAPS:
+                Let D be a union of arcs, taken on both sides. The first return map of T to D maps a point x of D to
+                T^r(x), where r > 0 is the smallest with T^r(x) in D. D is cut into finitely many pieces on which
+                r, the side of T^r(x) and the Intervals that x, T(x), ..., T^(r-1)(x) lie in are constant, and T^r is
+                an isometry on each piece. These pieces are stored, with the number of visits to each Interval
+                (m_IntervalIntersectionCount), so the return of a point takes one lookup instead of r steps.
+
+                The map is computed from the first return map to a larger set containing D (at first from T itself) by
+                following the domain in fragments: a fragment is moved by the coarser map until it is back in D, and
+                cut wherever it would straddle two pieces of the coarser map or the boundary of D. When D is half of
+                the coarser domain, a fragment returns after about two moves, so the cost does not depend on how large
+                the return times are.
+
+    USE:        FoliationRP2 builds induced maps to the arcs around the division points of its separatrix segments
+                (see ArcsAroundDivPoints). Nothing happens to a segment while it is outside of these arcs, except for
+                counting the Intervals, so the segment can skip from one return to the next.
+
+    ROUNDING:   The boundaries of the pieces and the images are computed with rounding. Fragments shorter than
+                INDUCTION_TOLERANCE roundings are thrown away, so the domain can have small holes, and points near the
+                boundary of a piece might really belong to the next one. Users must check DistanceFromBoundary. While
+                building the map, an image that falls into such a hole (or just outside of a piece, after rounding)
+                is taken to be in the next piece.
+ *
+ *
+ ******************************************************************************/
+
+#ifndef ArnouxYoccoz_InducedMap_h
+#define ArnouxYoccoz_InducedMap_h
+
+#include <vector>
+#include "FoliationDisk.h"
+#include "OrbitDatabase.h"
+
+
+
+const int INDUCTION_TOLERANCE = 1024;       // fragments shorter than this many roundings are thrown away
+const int INDUCTION_WORK_FACTOR = 64;       // how many moves per fragment are allowed, relative to the ratio of the domains
+
+
+class ExceptionInductionFailed {};
+
+
+
+template <typename Precision = DefaultPrecision>
+class InducedMap{
+public:
+    typedef typename Precision::real_type floating_point_type;
+    typedef typename Precision::coordinate_type circle_coordinate_type;
+    typedef ::CirclePoint<Precision> CirclePoint;
+    typedef ::Arc<Precision> Arc;
+    typedef ::FoliationDisk<Precision> FoliationDisk;
+    typedef typename CirclePoint::Coordinate Coordinate;
+
+    // An interval of the domain on which the first return is an isometry with the same itinerary for every point
+    struct Piece{
+        circle_coordinate_type m_Begin;
+        circle_coordinate_type m_Length;
+        bool m_FrontSide;           // which side of the Circle the piece is on
+        bool m_Reverses;            // x is mapped to m_Shift - x if true, to x + m_Shift if false
+        circle_coordinate_type m_Shift;
+        int m_ReturnTime;
+        std::vector<int> m_IntervalIntersectionCount;  // how many of x, T(x), ..., T^(m_ReturnTime - 1)(x) are in each Interval
+    };
+
+    InducedMap(const FoliationDisk& fd);       // the step map T itself, the domain is the whole Circle
+    InducedMap(const InducedMap& Coarser, const std::vector<Arc>& Domain);  // the first return to Domain, which must be in the domain of Coarser
+    InducedMap(StateReader& Reader);        // a map saved by Write
+    void Write(StateWriter& Writer) const;
+
+    const Piece* FindPiece(const circle_coordinate_type& x, bool FrontSide) const;     // NULL if x is not in the domain
+    circle_coordinate_type Apply(const Piece& p, const circle_coordinate_type& x) const;
+    floating_point_type DistanceFromBoundary(const Piece& p, const circle_coordinate_type& x) const;
+    floating_point_type GetMeasure() const{ return m_Measure; }    // the length of the domain on one side
+    int GetNumPieces() const{ return static_cast<int>(m_Pieces[0].size() + m_Pieces[1].size()); }
+
+private:
+    // A part of the domain that has been moved by the coarser map m_ReturnTime times, but has not returned yet
+    struct Fragment{
+        Piece m_Piece;              // the part of the domain and the composition of the moves so far
+        bool m_OnFrontSide;         // the side of the current image
+    };
+
+    std::vector<Piece> m_Pieces[2];     // the pieces on the back side (0) and the front side (1), sorted by m_Begin
+    floating_point_type m_Measure;
+    int m_NumIntervals;
+
+    static const Piece* FindIn(const std::vector<Piece>& Pieces, const circle_coordinate_type& x);
+    static const Piece* FindNear(const std::vector<Piece>& Pieces, const circle_coordinate_type& x, const circle_coordinate_type& Tolerance,
+                                 circle_coordinate_type& Distance);
+    static bool IsBefore(const Piece& p1, const Piece& p2){ return p1.m_Begin < p2.m_Begin; }
+    static bool BeginsAfter(const circle_coordinate_type& x, const Piece& p){ return x < p.m_Begin; }
+    static circle_coordinate_type ImageBegin(const Fragment& f);
+    static void Split(Fragment& f, const circle_coordinate_type& ImageLength, std::vector<Fragment>& Stack, const circle_coordinate_type& Tolerance);
+    static void Compose(Fragment& f, const Piece& p);
+};
+
+
+#endif
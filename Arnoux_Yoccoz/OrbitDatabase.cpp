@@ -0,0 +1,203 @@
+/*******************************************************************************
+ *  CLASS NAME:	OrbitDatabase
+ *  AUTHOR:		Balazs Strenner
+ *				Copyright 2013 UW-Madison. All rights reserved.
+ *
+ *	DESCRIPTION: Saving, reading and appending to the files of the database. See OrbitDatabase.h for how the files
+ *               and their logs are laid out.
+ *
+ ******************************************************************************/
+
+#include "OrbitDatabase.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+
+const char ORBIT_DATABASE_MAGIC[4] = {'A', 'Y', 'D', 'B'};
+
+
+
+
+void StateWriter::Write(const std::string& String){
+    Write(static_cast<long long>(String.size()));
+    m_Bytes.insert(m_Bytes.end(), String.begin(), String.end());
+}
+
+
+
+
+bool StateReader::Open(const std::string& Path){
+    Close();
+    int File = open(Path.c_str(), O_RDONLY);
+    if (File < 0) {
+        return false;
+    }
+    struct stat Status;
+    if (fstat(File, &Status) != 0 || Status.st_size == 0) {
+        close(File);
+        return false;
+    }
+    void* Mapping = mmap(NULL, static_cast<std::size_t>(Status.st_size), PROT_READ, MAP_PRIVATE, File, 0);
+    close(File);    // the mapping stays valid
+    if (Mapping == MAP_FAILED) {
+        return false;
+    }
+    m_Begin = static_cast<const char*>(Mapping);
+    m_MappedSize = static_cast<std::size_t>(Status.st_size);
+    m_Size = m_MappedSize;
+    m_Position = 0;
+    return true;
+}
+
+
+
+
+void StateReader::Close(){
+    if (m_Begin != NULL) {
+        munmap(const_cast<char*>(m_Begin), m_MappedSize);
+    }
+    m_Begin = NULL;
+    m_MappedSize = 0;
+    m_Size = 0;
+    m_Position = 0;
+}
+
+
+
+
+bool StateReader::Limit(std::size_t Size){
+    if (Size > m_Size) {
+        return false;
+    }
+    m_Size = Size;
+    return true;
+}
+
+
+
+
+void StateReader::Read(std::string& String){
+    long long Size = Read<long long>();
+    if (Size < 0) {
+        throw ExceptionCorruptState();
+    }
+    CheckRemaining(static_cast<std::size_t>(Size));
+    String.assign(m_Begin + m_Position, static_cast<std::size_t>(Size));
+    m_Position += static_cast<std::size_t>(Size);
+}
+
+
+
+
+
+
+
+
+
+OrbitDatabase OrbitDatabase::FromEnvironment(){
+    return OrbitDatabase(std::getenv(ORBIT_DATABASE_ENVIRONMENT_VARIABLE));
+}
+
+
+
+
+// The file begins with ORBIT_DATABASE_MAGIC and the format version, the rest is read by the caller.
+bool OrbitDatabase::Open(const std::string& Name, StateReader& Reader) const{
+    if (!IsEnabled() || !Reader.Open(GetPath(Name))) {
+        return false;
+    }
+    try {
+        char Magic[4];
+        for (int i = 0; i < 4; i++) {
+            Reader.Read(Magic[i]);
+        }
+        if (std::memcmp(Magic, ORBIT_DATABASE_MAGIC, 4) == 0 && Reader.Read<int>() == ORBIT_DATABASE_FORMAT_VERSION) {
+            return true;
+        }
+    } catch (const ExceptionCorruptState&) {}
+    Reader.Close();
+    return false;
+}
+
+
+
+
+bool OrbitDatabase::Store(const std::string& Name, const StateWriter& Writer) const{
+    if (!MakeDirectory()) {
+        return false;
+    }
+    // The process id makes the temporary file of each running program its own, so two programs saving the same
+    // object at the same time don't write into each other's file. The one that renames last wins, and either file
+    // is complete.
+    std::string TemporaryPath = GetPath(Name) + "." + std::to_string(static_cast<long long>(getpid())) + ".tmp";
+    int Descriptor = open(TemporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (Descriptor < 0) {
+        return false;
+    }
+    std::FILE* File = fdopen(Descriptor, "wb");
+    if (File == NULL) {
+        close(Descriptor);
+        std::remove(TemporaryPath.c_str());
+        return false;
+    }
+    int Version = ORBIT_DATABASE_FORMAT_VERSION;
+    const std::vector<char>& Bytes = Writer.GetBytes();
+    bool Written = std::fwrite(ORBIT_DATABASE_MAGIC, 1, 4, File) == 4 &&
+                   std::fwrite(&Version, sizeof(Version), 1, File) == 1 &&
+                   (Bytes.empty() || std::fwrite(&Bytes[0], 1, Bytes.size(), File) == Bytes.size());
+    Written = Written && std::fflush(File) == 0 && fsync(fileno(File)) == 0;     // on the disk before it replaces the old file
+    if (std::fclose(File) != 0 || !Written || std::rename(TemporaryPath.c_str(), GetPath(Name).c_str()) != 0) {
+        std::remove(TemporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+
+
+// An empty log has no file, since an empty file can't be mapped.
+bool OrbitDatabase::OpenLog(const std::string& Name, long long Size, StateReader& Reader) const{
+    if (Size == 0) {
+        Reader.Close();
+        return true;
+    }
+    return IsEnabled() && Reader.Open(GetLogPath(Name)) && Reader.Limit(static_cast<std::size_t>(Size));
+}
+
+
+
+
+// The new entries are on the disk when this returns true, so the file can be saved with the new length.
+bool OrbitDatabase::AppendToLog(const std::string& Name, long long Size, const StateWriter& Writer) const{
+    if (!MakeDirectory()) {
+        return false;
+    }
+    int File = open(GetLogPath(Name).c_str(), O_WRONLY | O_CREAT, 0666);
+    if (File < 0) {
+        return false;
+    }
+    const std::vector<char>& Bytes = Writer.GetBytes();
+    bool Written = ftruncate(File, static_cast<off_t>(Size)) == 0 && lseek(File, static_cast<off_t>(Size), SEEK_SET) >= 0;
+    for (std::size_t Position = 0; Written && Position < Bytes.size(); ) {
+        ssize_t NumWritten = write(File, &Bytes[Position], Bytes.size() - Position);
+        Written = NumWritten > 0;
+        Position += Written ? static_cast<std::size_t>(NumWritten) : 0;
+    }
+    Written = Written && fsync(File) == 0;
+    return close(File) == 0 && Written;
+}
+
+
+
+
+// The directory is created if it does not exist yet.
+bool OrbitDatabase::MakeDirectory() const{
+    return IsEnabled() && (mkdir(m_Directory.c_str(), 0777) == 0 || errno == EEXIST);
+}
@@ -0,0 +1,170 @@
+/*******************************************************************************
+ *  CLASS NAME:	OrbitDatabase
+ *  AUTHOR:		Balazs Strenner
+ *				Copyright 2013 UW-Madison. All rights reserved.
+ *
+ *	DESCRIPTION: A directory of files in which searches are kept between runs of the program.
+
+    FILES:      Each file holds the state of one object (e.g. a FoliationRP2 in one precision) and is named by the
+                object from a hash of its data. The object writes its data at the beginning of the file and checks it
+                when the file is read, so a file of another object with the same name is not mistaken for its own.
+                A file is written under a temporary name of its own (with the process id), flushed to the disk, and
+                renamed when it is complete, so a file is never left half written, even if the program or the machine
+                is stopped while saving, or another run of the program saves the same object at the same time.
+
+    LOGS:       Data that is only ever appended to (e.g. the good segments of a search) need not be written again
+                with every save. It goes to the log of the file, another file that is only appended to (AppendToLog),
+                and the file records how long the log was when it was saved. A log is cut back to that length before
+                anything is appended, so whatever was appended after the last save of the file (e.g. just before a
+                crash) is dropped, and the log always goes with its file.
+
+    READING:    A file is mapped into memory (mmap), and StateReader reads the entries one after the other straight
+                from the mapping, so the file is not copied into a buffer first.
+
+    FORMAT:     The entries are written as their bytes (StateWriter), so a file can only be read by the same build of
+                the program on the same kind of machine. A vector is written as its size followed by its entries.
+                Objects made of other objects write their members one by one. Files with another
+                ORBIT_DATABASE_FORMAT_VERSION are ignored.
+
+    USE:        The directory is given by the environment variable ORBIT_DATABASE_ENVIRONMENT_VARIABLE. If it is not
+                set, nothing is read or written. FoliationRP2 keeps its separatrix segments and induced maps here (see
+                FoliationRP2::SaveState), so a search on a foliation entered again continues where it was left.
+ *
+ *
+ ******************************************************************************/
+
+#ifndef ArnouxYoccoz_OrbitDatabase_h
+#define ArnouxYoccoz_OrbitDatabase_h
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <type_traits>
+
+
+
+const char* const ORBIT_DATABASE_ENVIRONMENT_VARIABLE = "ARNOUX_YOCCOZ_DATABASE";
+const int ORBIT_DATABASE_FORMAT_VERSION = 2;
+
+
+class ExceptionCorruptState {};
+
+
+
+//-------------//
+// StateWriter //
+//-------------//
+
+class StateWriter{
+public:
+    template <typename T> void Write(const T& Value);
+    template <typename T> void Write(const std::vector<T>& Values);
+    void Write(const std::string& String);
+    const std::vector<char>& GetBytes() const{ return m_Bytes; }
+
+private:
+    std::vector<char> m_Bytes;
+};
+
+
+
+//-------------//
+// StateReader //
+//-------------//
+
+class StateReader{
+public:
+    StateReader() : m_Begin(NULL), m_MappedSize(0), m_Size(0), m_Position(0) {}
+    ~StateReader(){ Close(); }
+
+    bool Open(const std::string& Path);     // false if the file can't be mapped
+    void Close();
+    template <typename T> void Read(T& Value);          // throws ExceptionCorruptState if the file is shorter
+    template <typename T> void Read(std::vector<T>& Values);
+    void Read(std::string& String);
+    template <typename T> T Read(){ T Value; Read(Value); return Value; }
+    bool IsAtEnd() const{ return m_Position == m_Size; }
+    bool Limit(std::size_t Size);           // only the first Size bytes are read, false if the file is shorter
+
+private:
+    const char* m_Begin;        // the mapped file
+    std::size_t m_MappedSize;
+    std::size_t m_Size;         // how much of it is read
+    std::size_t m_Position;     // the beginning of the next entry
+
+    void CheckRemaining(std::size_t NumBytes) const{ if (m_Size - m_Position < NumBytes) throw ExceptionCorruptState(); }
+    StateReader(const StateReader&);                // the mapping belongs to one object
+    StateReader& operator=(const StateReader&);
+};
+
+
+
+//---------------//
+// OrbitDatabase //
+//---------------//
+
+class OrbitDatabase{
+public:
+    OrbitDatabase(const char* Directory) : m_Directory(Directory == NULL ? "" : Directory) {}   // an empty or NULL Directory disables it
+    static OrbitDatabase FromEnvironment();
+
+    bool IsEnabled() const{ return !m_Directory.empty(); }
+    bool Open(const std::string& Name, StateReader& Reader) const;      // false if there is no file of this name (of this format)
+    bool Store(const std::string& Name, const StateWriter& Writer) const;   // false if the file can't be written
+    bool OpenLog(const std::string& Name, long long Size, StateReader& Reader) const;    // the first Size bytes of the log, false if it is shorter
+    bool AppendToLog(const std::string& Name, long long Size, const StateWriter& Writer) const;     // cuts the log to Size bytes first
+
+private:
+    std::string m_Directory;
+
+    std::string GetPath(const std::string& Name) const{ return m_Directory + "/" + Name; }
+    std::string GetLogPath(const std::string& Name) const{ return GetPath(Name) + ".log"; }
+    bool MakeDirectory() const;
+};
+
+
+
+
+template <typename T>
+void StateWriter::Write(const T& Value){
+    static_assert(std::is_trivially_copyable<T>::value, "only plain data is written as bytes");
+    const char* Bytes = reinterpret_cast<const char*>(&Value);
+    m_Bytes.insert(m_Bytes.end(), Bytes, Bytes + sizeof(T));
+}
+
+
+template <typename T>
+void StateWriter::Write(const std::vector<T>& Values){
+    Write(static_cast<long long>(Values.size()));
+    for (int i = 0; i < Values.size(); i++) {
+        Write(Values[i]);
+    }
+}
+
+
+
+
+template <typename T>
+void StateReader::Read(T& Value){
+    static_assert(std::is_trivially_copyable<T>::value, "only plain data is read as bytes");
+    CheckRemaining(sizeof(T));
+    std::memcpy(&Value, m_Begin + m_Position, sizeof(T));    // the entries are not aligned in the file
+    m_Position += sizeof(T);
+}
+
+
+template <typename T>
+void StateReader::Read(std::vector<T>& Values){
+    long long Size = Read<long long>();
+    if (Size < 0 || Size > static_cast<long long>(m_Size - m_Position)) {   // every entry takes at least a byte
+        throw ExceptionCorruptState();
+    }
+    Values.resize(static_cast<std::size_t>(Size));
+    for (int i = 0; i < Values.size(); i++) {
+        Read(Values[i]);
+    }
+}
+
+
+
+#endif
@@ -0,0 +1,213 @@
+/*******************************************************************************
+ *  AUTHOR:		Balazs Strenner
+ *				Copyright 2013 UW-Madison. All rights reserved.
+ *
+ *  DESCRIPTION: The numeric policies that CirclePoint, Arc, ArcsAroundDivPoints, FoliationDisk,
+                FoliationRP2 and AlmostPFMatrix are parametrized by.
+
+    MORE DETAILS: A policy is Precision<Real, Coordinate>. Real is the type of lengths and distances,
+                Coordinate is the type in which CirclePoint stores its position on the circle. Usually
+                they are the same, but the coordinate can also be a FixedPoint.
+
+                The available policies are
+                    DoublePrecision         double
+                    LongDoublePrecision     long double
+                    DoubleDoublePrecision   DoubleDouble, about 106 bits
+                    QuadPrecision           __float128, 113 bits, where the compiler supports it
+                    FixedPoint64Precision   long double lengths, 64 bit fixed point coordinates
+                    FixedPoint128Precision  long double lengths, 128 bit fixed point coordinates,
+                                            where the compiler supports unsigned __int128
+
+                All of them are instantiated in one binary (see FOR_EACH_PRECISION), so a search can run in
+                double and the interesting results can be checked in higher precision without rebuilding.
+                DefaultPrecision is what the interactive program uses. It is LongDoublePrecision, unless
+                FIXED_POINT_CIRCLE (or FIXED_POINT_CIRCLE_128) is defined. HigherPrecision<P> is the policy that
+                single orbits are recomputed in when P is not precise enough for them.
+
+                For a type Real the code below relies on the usual arithmetic operators and comparisons,
+                conversion from int and double, operator<< and the functions Floor and Abs.
+
+ ******************************************************************************/
+
+#ifndef ArnouxYoccoz_Precision_h
+#define ArnouxYoccoz_Precision_h
+
+#include <iostream>
+#include <cmath>
+#include <stdint.h>
+#include <limits>
+#include "DoubleDouble.h"
+
+#if defined(__SIZEOF_FLOAT128__) && !defined(__clang__)     // clang does not allow mixing __float128 and long double
+#define HAS_QUAD_PRECISION
+#endif
+
+
+
+//-------------------------------//
+// Functions of the number types //
+//-------------------------------//
+
+// (DoubleDouble has its own Floor and Abs.)
+inline double Floor(double t){ return std::floor(t); }
+inline long double Floor(long double t){ return std::floor(t); }
+inline double Abs(double t){ return std::fabs(t); }
+inline long double Abs(long double t){ return std::fabs(t); }
+
+#ifdef HAS_QUAD_PRECISION
+// There is no libquadmath on every platform, so the few functions we need are written here.
+inline __float128 Floor(__float128 t){
+    const __float128 TWO_TO_THE_112 = 5192296858534827628530496329220096.0L;   // 2^112 is exactly representable in long double
+    if (!(t < TWO_TO_THE_112 && -t < TWO_TO_THE_112)) {
+        return t;                        // already an integer (or not a number)
+    }
+    // Adding and subtracting 2^112 rounds to the nearest integer
+    __float128 Rounded = t < 0 ? (t - TWO_TO_THE_112) + TWO_TO_THE_112 : (t + TWO_TO_THE_112) - TWO_TO_THE_112;
+    return Rounded > t ? Rounded - 1 : Rounded;
+}
+inline __float128 Abs(__float128 t){ return t < 0 ? -t : t; }
+
+// Only the first 64 bits are printed.
+inline std::ostream& operator<<(std::ostream& Out, __float128 t){ return Out << static_cast<long double>(t); }
+#endif
+
+
+// The gap between 1 and the next representable number.
+template <typename Real>
+inline Real Epsilon(){ return std::numeric_limits<Real>::epsilon(); }
+template <>
+inline DoubleDouble Epsilon<DoubleDouble>(){ return DoubleDouble(std::ldexp(1.0, -104)); }
+#ifdef HAS_QUAD_PRECISION
+template <>
+inline __float128 Epsilon<__float128>(){ return std::ldexp(1.0L, -112); }
+#endif
+
+
+// The fractional part of any real number. Works for negatives, too: FracPart(-0.3)=0.7.
+template <typename Real>
+inline Real FracPart(const Real& t){ return t - Floor(t); }
+
+
+#include "FixedPoint.h"     // the conversion from real numbers uses Floor
+
+
+
+//------------------//
+// CoordinateTraits //
+//------------------//
+
+// How CirclePoint handles its coordinate. This general version is for real number types,
+// which are reduced modulo 1 by taking the fractional part.
+template <typename Coordinate>
+struct CoordinateTraits{
+    template <typename Real>
+    static Coordinate FromReal(const Real& t){ return FracPart(Coordinate(t)); }       // the coordinate of the point t mod 1
+    static Coordinate Reduce(const Coordinate& t){ return FracPart(t); }               // reduces a sum or difference of coordinates
+    template <typename Real>
+    static Real ToReal(const Coordinate& t){ return Real(t); }
+
+    // the distance from From to To, going to the right
+    template <typename Real>
+    static Real DistanceToTheRight(const Coordinate& From, const Coordinate& To){ return Real(From <= To ? To - From : To - From + 1); }
+
+    // an upper bound for the rounding error of one addition or subtraction of coordinates, followed by Reduce
+    template <typename Real>
+    static Real RoundingError(){ return Real(Epsilon<Coordinate>()); }
+
+    static Coordinate Half(){ return Coordinate(0.5); }
+    static Coordinate UpperBound(){ return Coordinate(1); }     // not less than any coordinate
+};
+
+
+// FixedPoints are always reduced, and going around the circle is just integer overflow.
+template <typename Word>
+struct CoordinateTraits<FixedPoint<Word>>{
+    template <typename Real>
+    static FixedPoint<Word> FromReal(const Real& t){ return FixedPoint<Word>(t); }
+    static FixedPoint<Word> Reduce(const FixedPoint<Word>& t){ return t; }
+    template <typename Real>
+    static Real ToReal(const FixedPoint<Word>& t){ return t.template ToReal<Real>(); }
+
+    template <typename Real>
+    static Real DistanceToTheRight(const FixedPoint<Word>& From, const FixedPoint<Word>& To){ return (To - From).template ToReal<Real>(); }
+
+    template <typename Real>
+    static Real RoundingError(){ return Real(0); }      // the arithmetic is exact
+
+    static FixedPoint<Word> Half(){ return FixedPoint<Word>::FromRaw(Word(1) << (8 * sizeof(Word) - 1)); }
+    static FixedPoint<Word> UpperBound(){ return FixedPoint<Word>::Max(); }
+};
+
+
+
+//-----------//
+// Precision //
+//-----------//
+
+template <typename Real, typename Coordinate = Real>
+struct Precision{
+    typedef Real real_type;
+    typedef Coordinate coordinate_type;
+};
+
+typedef Precision<double> DoublePrecision;
+typedef Precision<long double> LongDoublePrecision;
+typedef Precision<DoubleDouble> DoubleDoublePrecision;
+typedef Precision<long double, FixedPoint64> FixedPoint64Precision;
+#ifdef HAS_QUAD_PRECISION
+typedef Precision<__float128> QuadPrecision;
+#endif
+#ifdef __SIZEOF_INT128__
+typedef Precision<long double, FixedPoint128> FixedPoint128Precision;
+#endif
+
+
+#if defined(FIXED_POINT_CIRCLE_128) && defined(__SIZEOF_INT128__)
+typedef FixedPoint128Precision DefaultPrecision;
+#elif defined(FIXED_POINT_CIRCLE) || defined(FIXED_POINT_CIRCLE_128)
+typedef FixedPoint64Precision DefaultPrecision;
+#else
+typedef LongDoublePrecision DefaultPrecision;
+#endif
+
+typedef DefaultPrecision::real_type floating_point_type;
+
+
+
+// The policy a computation is redone in when P is not precise enough (see FoliationRP2::Lengthen).
+// Following leaves is exact with FixedPoint coordinates, so those policies, like the ones with no more precise
+// counterpart, are mapped to themselves.
+template <typename P>
+struct HigherPrecision{ typedef P type; };
+template <>
+struct HigherPrecision<DoublePrecision>{ typedef DoubleDoublePrecision type; };
+template <>
+struct HigherPrecision<LongDoublePrecision>{ typedef DoubleDoublePrecision type; };
+
+
+
+// Calls INSTANTIATE(P) for every policy P above. The .cpp files of the parametrized classes use it for
+// explicit instantiation.
+#ifdef HAS_QUAD_PRECISION
+#define FOR_QUAD_PRECISION(INSTANTIATE) INSTANTIATE(QuadPrecision)
+#else
+#define FOR_QUAD_PRECISION(INSTANTIATE)
+#endif
+
+#ifdef __SIZEOF_INT128__
+#define FOR_FIXED_POINT128_PRECISION(INSTANTIATE) INSTANTIATE(FixedPoint128Precision)
+#else
+#define FOR_FIXED_POINT128_PRECISION(INSTANTIATE)
+#endif
+
+#define FOR_EACH_PRECISION(INSTANTIATE) \
+    INSTANTIATE(DoublePrecision) \
+    INSTANTIATE(LongDoublePrecision) \
+    INSTANTIATE(DoubleDoublePrecision) \
+    FOR_QUAD_PRECISION(INSTANTIATE) \
+    INSTANTIATE(FixedPoint64Precision) \
+    FOR_FIXED_POINT128_PRECISION(INSTANTIATE)
+
+
+
+#endif
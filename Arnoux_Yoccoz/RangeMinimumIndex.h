@@ -0,0 +1,87 @@
+/*******************************************************************************
+ *  CLASS NAME:	RangeMinimumIndex
+ *  AUTHOR:		Balazs Strenner
+ *				Copyright 2013 UW-Madison. All rights reserved.
+ *
+ *	DESCRIPTION: Integer values at positions given by keys, answering which is the smallest value at the keys in a range.
+
+    STORAGE:    The keys are kept sorted, with their values in the same order, and the minima of the values are stored in
+                a segment tree over the sorted positions: m_Tree[1] is the minimum of all of them, and the children of
+                m_Tree[i] are m_Tree[2 * i] and m_Tree[2 * i + 1], down to the leaves m_Tree[m_Capacity + Position]. So
+                the minimum over a range of positions is found in O(log n) steps. Inserting a key moves the positions
+                after it, and the tree is rebuilt, which takes O(n) steps. So this is for many more queries than keys.
+
+    USE:        The coordinates of the endpoints of the good shifted separatrix segments of a separatrix, with the
+                index of the segment (i.e. the order of its depth) as value. The first segment whose endpoint is on an
+                arc of the Circle is the minimum over the keys on the arc (GetFirstIntersection).
+ *
+ *
+ ******************************************************************************/
+
+#ifndef ArnouxYoccoz_RangeMinimumIndex_h
+#define ArnouxYoccoz_RangeMinimumIndex_h
+
+#include <vector>
+#include <algorithm>
+#include <climits>
+
+
+
+template <typename Key>
+class RangeMinimumIndex{
+public:
+    RangeMinimumIndex() : m_Capacity(0) {}
+
+    int Size() const{ return static_cast<int>(m_Keys.size()); }
+    int LowerBound(const Key& k) const{ return static_cast<int>(std::lower_bound(m_Keys.begin(), m_Keys.end(), k) - m_Keys.begin()); }  // the number of keys less than k
+    int UpperBound(const Key& k) const{ return static_cast<int>(std::upper_bound(m_Keys.begin(), m_Keys.end(), k) - m_Keys.begin()); }  // the number of keys not greater than k
+    int GetMinimum(int First, int Last) const;     // the smallest value at the sorted positions First, ..., Last - 1, INT_MAX if there is none
+    void Insert(const Key& k, int Value);
+
+private:
+    std::vector<Key> m_Keys;        // sorted
+    std::vector<int> m_Values;      // the value of each key
+    std::vector<int> m_Tree;        // the minima, see above
+    int m_Capacity;                 // the number of leaves of m_Tree, a power of 2
+};
+
+
+
+
+template <typename Key>
+int RangeMinimumIndex<Key>::GetMinimum(int First, int Last) const{
+    int Minimum = INT_MAX;
+    for (First += m_Capacity, Last += m_Capacity; First < Last; First /= 2, Last /= 2) {
+        if (First % 2 == 1) {
+            Minimum = std::min(Minimum, m_Tree[First++]);
+        }
+        if (Last % 2 == 1) {
+            Minimum = std::min(Minimum, m_Tree[--Last]);
+        }
+    }
+    return Minimum;
+}
+
+
+
+
+// A key equal to some keys already there goes after them.
+template <typename Key>
+void RangeMinimumIndex<Key>::Insert(const Key& k, int Value){
+    int Position = UpperBound(k);
+    m_Keys.insert(m_Keys.begin() + Position, k);
+    m_Values.insert(m_Values.begin() + Position, Value);
+
+    if (m_Capacity < Size()) {
+        m_Capacity = m_Capacity == 0 ? 1 : 2 * m_Capacity;
+    }
+    m_Tree.assign(2 * m_Capacity, INT_MAX);
+    std::copy(m_Values.begin(), m_Values.end(), m_Tree.begin() + m_Capacity);
+    for (int i = m_Capacity - 1; i > 0; i--) {
+        m_Tree[i] = std::min(m_Tree[2 * i], m_Tree[2 * i + 1]);
+    }
+}
+
+
+
+#endif
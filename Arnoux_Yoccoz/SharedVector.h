@@ -0,0 +1,118 @@
+/*******************************************************************************
+ *  CLASS NAME:	SharedVector
+ *  AUTHOR:		Balazs Strenner
+ *				Copyright 2013 UW-Madison. All rights reserved.
+ *
+ *	DESCRIPTION: An array that shares its entries with its copies until they are changed.
+
+    STORAGE:    The entries are stored in a base array (m_Base), which is shared by an object and its copies, and a
+                short list of changed entries (m_Changes), which belongs to one object only. So copying an object costs
+                only as much as copying its changes.
+
+                Changing an entry while the base is shared adds it to the changes. When there would be more than
+                1 / SHARED_VECTOR_CHANGES_RATIO of the entries among the changes, they are merged into a new base that
+                is not shared, and from then on the entries are changed in place until the object is copied again.
+
+    USE:        A SeparatrixSegment is copied whenever it is saved as a good one, and then the copies and the original
+                are changed in only a few entries (shifting the copies changes one or two counts and Arcs), so most of
+                the entries of the copies are stored only once.
+ *
+ *
+ ******************************************************************************/
+
+#ifndef ArnouxYoccoz_SharedVector_h
+#define ArnouxYoccoz_SharedVector_h
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+
+const int SHARED_VECTOR_CHANGES_RATIO = 4;
+
+
+
+template <typename T>
+class SharedVector{
+public:
+    SharedVector() : m_Base(std::make_shared<std::vector<T>>()) {}
+    SharedVector(int Size, const T& Value) : m_Base(std::make_shared<std::vector<T>>(Size, Value)) {}
+    explicit SharedVector(const std::vector<T>& Entries) : m_Base(std::make_shared<std::vector<T>>(Entries)) {}
+
+    int Size() const{ return static_cast<int>(m_Base->size()); }
+    const T& operator[](int Index) const{ return m_Changes.empty() ? (*m_Base)[Index] : Find(Index); }
+    T& Modify(int Index);           // the entry to be changed, the reference is valid until the next call of Modify
+    std::vector<T> ToVector() const;
+
+private:
+    std::shared_ptr<std::vector<T>> m_Base;
+    std::vector<std::pair<int, T>> m_Changes;   // the index and the new value of the entries changed since the copy
+
+    const T& Find(int Index) const;
+    void Merge();
+};
+
+
+
+
+template <typename T>
+T& SharedVector<T>::Modify(int Index){
+    if (m_Base.use_count() > 1) {
+        for (int k = 0; k < m_Changes.size(); k++) {
+            if (m_Changes[k].first == Index) {
+                return m_Changes[k].second;
+            }
+        }
+        if (m_Changes.size() < m_Base->size() / SHARED_VECTOR_CHANGES_RATIO) {
+            m_Changes.push_back(std::make_pair(Index, (*m_Base)[Index]));
+            return m_Changes.back().second;
+        }
+    }
+    Merge();
+    return (*m_Base)[Index];
+}
+
+
+
+
+template <typename T>
+std::vector<T> SharedVector<T>::ToVector() const{
+    std::vector<T> Entries(*m_Base);
+    for (int k = 0; k < m_Changes.size(); k++) {
+        Entries[m_Changes[k].first] = m_Changes[k].second;
+    }
+    return Entries;
+}
+
+
+
+
+template <typename T>
+const T& SharedVector<T>::Find(int Index) const{
+    for (int k = 0; k < m_Changes.size(); k++) {
+        if (m_Changes[k].first == Index) {
+            return m_Changes[k].second;
+        }
+    }
+    return (*m_Base)[Index];
+}
+
+
+
+
+// Makes the base unshared (if it is shared) and moves the changes into it.
+template <typename T>
+void SharedVector<T>::Merge(){
+    if (m_Base.use_count() > 1) {
+        m_Base = std::make_shared<std::vector<T>>(*m_Base);
+    }
+    for (int k = 0; k < m_Changes.size(); k++) {
+        (*m_Base)[m_Changes[k].first] = m_Changes[k].second;
+    }
+    m_Changes.clear();
+}
+
+
+
+#endif
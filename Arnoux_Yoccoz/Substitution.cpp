@@ -0,0 +1,219 @@
+/*******************************************************************************
+ *  CLASS NAME:	Substitution
+ *  AUTHOR:		Balazs Strenner
+ *				Copyright 2013 UW-Madison. All rights reserved.
+ *
+ ******************************************************************************/
+
+
+#include "Substitution.h"
+#include <algorithm>
+#include <climits>
+#include <map>
+
+
+
+const long long MAX_COUNT = LLONG_MAX / 2;     // lengths and counts are cut off here, only the ones below are ever used
+
+inline long long SaturatedSum(long long a, long long b){
+    return a < MAX_COUNT - b ? a + b : MAX_COUNT;
+}
+
+
+
+
+// Z[p] is the length of the longest common prefix of Sequence and the part of Sequence starting at p.
+std::vector<int> Substitution::GetPrefixLengths(const std::vector<int>& Sequence){
+    int Size = static_cast<int>(Sequence.size());
+    std::vector<int> Z(Size, 0);
+    if (Size > 0) {
+        Z[0] = Size;
+    }
+    for (int p = 1, Left = 0, Right = 0; p < Size; p++) {
+        if (p < Right) {
+            Z[p] = std::min(Right - p, Z[p - Left]);
+        }
+        while (p + Z[p] < Size && Sequence[Z[p]] == Sequence[p + Z[p]]) {
+            Z[p]++;
+        }
+        if (p + Z[p] > Right) {
+            Left = p;
+            Right = p + Z[p];
+        }
+    }
+    return Z;
+}
+
+
+
+
+// The derived sequence with respect to the prefix of length PrefixLength. The words after the last occurrence of the
+// prefix is not a complete return word, so it is left out.
+Substitution::DerivedSequence Substitution::Derive(const std::vector<int>& Sequence, const std::vector<int>& Z, int PrefixLength){
+    DerivedSequence d;
+    for (int p = 0; p < Sequence.size(); p++) {
+        if (Z[p] >= PrefixLength) {
+            d.m_Occurrences.push_back(p);
+        }
+    }
+    std::map<std::vector<int>, int> Numbering;
+    for (int t = 0; t + 1 < d.m_Occurrences.size(); t++) {
+        std::vector<int> ReturnWord(Sequence.begin() + d.m_Occurrences[t], Sequence.begin() + d.m_Occurrences[t + 1]);
+        std::map<std::vector<int>, int>::const_iterator it = Numbering.find(ReturnWord);
+        if (it == Numbering.end()) {
+            it = Numbering.insert(std::make_pair(ReturnWord, static_cast<int>(d.m_FirstAppearance.size()))).first;
+            d.m_FirstAppearance.push_back(t);
+        }
+        d.m_Sequence.push_back(it->second);
+    }
+    return d;
+}
+
+
+
+
+// We go through the prefixes in increasing order, but only those that have fewer occurrences than the previous one,
+// since the derived sequence depends only on the occurrences. The first derived sequence that agrees with an earlier
+// one (on the shorter of the two) gives the substitution.
+Substitution::Substitution(const std::vector<int>& Sequence, int NumLetters) :
+    m_NumLetters(NumLetters)
+{
+    std::vector<int> Z = GetPrefixLengths(Sequence);
+    std::vector<int> PrefixLengths(1, 1);
+    for (int p = 1; p < Z.size(); p++) {
+        PrefixLengths.push_back(Z[p] + 1);
+    }
+    std::sort(PrefixLengths.begin(), PrefixLengths.end());
+    PrefixLengths.erase(std::unique(PrefixLengths.begin(), PrefixLengths.end()), PrefixLengths.end());
+
+    std::vector<DerivedSequence> Earlier;
+    for (int k = 0; k < PrefixLengths.size(); k++) {
+        DerivedSequence d = Derive(Sequence, Z, PrefixLengths[k]);
+        if (d.m_Sequence.size() < SUBSTITUTION_MIN_RETURNS) {
+            break;
+        }
+        for (int l = 0; l < Earlier.size(); l++) {
+            const DerivedSequence& e = Earlier[l];
+            if (e.m_FirstAppearance.size() == d.m_FirstAppearance.size() &&
+                std::equal(d.m_Sequence.begin(), d.m_Sequence.end(), e.m_Sequence.begin())) {
+
+                // The occurrences of the longer prefix are among the occurrences of the shorter one.
+                m_Images.resize(d.m_FirstAppearance.size());
+                for (int i = 0; i < m_Images.size(); i++) {
+                    int t = d.m_FirstAppearance[i];
+                    int Begin = static_cast<int>(std::lower_bound(e.m_Occurrences.begin(), e.m_Occurrences.end(), d.m_Occurrences[t]) - e.m_Occurrences.begin());
+                    int End = static_cast<int>(std::lower_bound(e.m_Occurrences.begin(), e.m_Occurrences.end(), d.m_Occurrences[t + 1]) - e.m_Occurrences.begin());
+                    m_Images[i].assign(e.m_Sequence.begin() + Begin, e.m_Sequence.begin() + End);
+                }
+                if (m_Images[0].size() < 2) {
+                    // the fixed point is not generated from the first return word
+                    m_Images.clear();
+                    continue;
+                }
+                for (int i = 0; i < e.m_FirstAppearance.size(); i++) {
+                    int t = e.m_FirstAppearance[i];
+                    m_ReturnWords.push_back(std::vector<int>(Sequence.begin() + e.m_Occurrences[t], Sequence.begin() + e.m_Occurrences[t + 1]));
+                }
+                return;
+            }
+        }
+        Earlier.push_back(d);
+    }
+    throw ExceptionNoSubstitutionFound();
+}
+
+
+
+
+std::vector<std::vector<int>> Substitution::GetMatrix() const{
+    std::vector<std::vector<int>> Matrix(m_Images.size(), std::vector<int>(m_Images.size(), 0));
+    for (int i = 0; i < m_Images.size(); i++) {
+        for (int k = 0; k < m_Images[i].size(); k++) {
+            Matrix[i][m_Images[i][k]]++;
+        }
+    }
+    return Matrix;
+}
+
+
+
+
+// Going down from a high enough level, the prefix of lambda(sigma^m(i)) is the concatenation of the lambda(sigma^(m-1)(j))
+// for the first few letters j of sigma(i), and a prefix of the next one.
+std::vector<long long> Substitution::CountLetters(long long Length) const{
+    std::vector<long long> Count(m_NumLetters, 0);
+    if (m_Lengths.empty()) {
+        AddLevel();
+    }
+    int Level = 0;
+    while (m_Lengths[Level][0] < Length) {
+        if (++Level == m_Lengths.size()) {
+            AddLevel();
+        }
+    }
+
+    int ReturnWord = 0;
+    for (; Level > 0 && Length > 0; Level--) {
+        const std::vector<int>& Image = m_Images[ReturnWord];
+        for (int k = 0; k < Image.size(); k++) {
+            ReturnWord = Image[k];
+            if (m_Lengths[Level - 1][ReturnWord] > Length) {
+                break;
+            }
+            Length -= m_Lengths[Level - 1][ReturnWord];
+            for (int Letter = 0; Letter < m_NumLetters; Letter++) {
+                Count[Letter] += m_Counts[Level - 1][ReturnWord][Letter];
+            }
+        }
+    }
+    for (int k = 0; k < Length; k++) {
+        Count[m_ReturnWords[ReturnWord][k]]++;
+    }
+    return Count;
+}
+
+
+
+
+// Computes the lengths and letter counts of lambda(sigma^m(i)) for the next m.
+void Substitution::AddLevel() const{
+    int Size = static_cast<int>(m_Images.size());
+    std::vector<long long> Lengths(Size, 0);
+    std::vector<std::vector<long long>> Counts(Size, std::vector<long long>(m_NumLetters, 0));
+    for (int i = 0; i < Size; i++) {
+        if (m_Lengths.empty()) {
+            Lengths[i] = m_ReturnWords[i].size();
+            for (int k = 0; k < m_ReturnWords[i].size(); k++) {
+                Counts[i][m_ReturnWords[i][k]]++;
+            }
+        } else {
+            for (int k = 0; k < m_Images[i].size(); k++) {
+                int j = m_Images[i][k];
+                Lengths[i] = SaturatedSum(Lengths[i], m_Lengths.back()[j]);
+                for (int Letter = 0; Letter < m_NumLetters; Letter++) {
+                    Counts[i][Letter] = SaturatedSum(Counts[i][Letter], m_Counts.back()[j][Letter]);
+                }
+            }
+        }
+    }
+    m_Lengths.push_back(Lengths);
+    m_Counts.push_back(Counts);
+}
+
+
+
+
+std::ostream& operator<<(std::ostream& Out, const Substitution& s){
+    for (int i = 0; i < s.m_Images.size(); i++) {
+        Out << i << " -> ";
+        for (int k = 0; k < s.m_Images[i].size(); k++) {
+            Out << s.m_Images[i][k] << " ";
+        }
+        Out << "  (";
+        for (int k = 0; k < s.m_ReturnWords[i].size(); k++) {
+            Out << (k > 0 ? " " : "") << s.m_ReturnWords[i][k];
+        }
+        Out << ")" << std::endl;
+    }
+    return Out;
+}
@@ -0,0 +1,79 @@
+/*******************************************************************************
+ *  CLASS NAME:	Substitution
+ *  AUTHOR:		Balazs Strenner
+ *				Copyright 2013 UW-Madison. All rights reserved.
+ *
+ *	DESCRIPTION: A substitution detected from a prefix of a sequence, typically the itinerary of a separatrix.
+
+    RETURN WORDS:
+                Let w be a prefix of the sequence u. The return words of w are the words between two consecutive
+                occurrences of w in u. Numbering them in the order of their first appearance, u is coded by the sequence
+                of the numbers of its return words, the derived sequence of u with respect to w.
+
+    DETECTION:  If u is the fixed point of a primitive substitution (or a coding of one), as the itineraries of
+                the separatrices of pseudo-anosov foliations are, then there are only finitely many different derived
+                sequences (Durand). So if w' is a longer prefix than w with the same derived sequence, then each
+                return word of w' is a concatenation of return words of w, and writing the i-th return word of w' as
+                the sequence of these gives sigma(i), a substitution fixing the derived sequence. The sequence is then
+                lambda(sigma^infinity(0)), where lambda(i) is the i-th return word of w.
+
+                Only a prefix of u is known, so the derived sequences are compared on the part covered by the prefix,
+                and at least SUBSTITUTION_MIN_RETURNS returns are required for a match.
+
+    USE:        Once the substitution is known, the number of each letter in arbitrarily long prefixes of u are
+                computed from the lengths and letter counts of lambda(sigma^m(i)) in O(m) steps for a prefix of length
+                about the m'th power of the expansion factor. (See CountLetters.)
+ *
+ *
+ ******************************************************************************/
+
+#ifndef ArnouxYoccoz_Substitution_h
+#define ArnouxYoccoz_Substitution_h
+
+#include <iostream>
+#include <vector>
+
+
+
+const int SUBSTITUTION_MIN_RETURNS = 64;      // a derived sequence shorter than this is not trusted
+
+
+class ExceptionNoSubstitutionFound {};
+
+
+
+class Substitution{
+public:
+    Substitution(const std::vector<int>& Sequence, int NumLetters);     // throws ExceptionNoSubstitutionFound
+
+    int GetNumLetters() const{ return m_NumLetters; }
+    int GetNumReturnWords() const{ return static_cast<int>(m_Images.size()); }
+    std::vector<std::vector<int>> GetMatrix() const;            // entry (i, j) is the number of j's in sigma(i)
+    std::vector<long long> CountLetters(long long Length) const;   // the number of each letter in the first Length letters of the sequence
+    friend std::ostream& operator<<(std::ostream& Out, const Substitution& s);
+
+private:
+    std::vector<std::vector<int>> m_Images;         // sigma(i), in terms of return words
+    std::vector<std::vector<int>> m_ReturnWords;    // lambda(i), in terms of the letters
+    int m_NumLetters;
+
+    // The lengths and letter counts of lambda(sigma^m(i)), for as many m's as needed so far
+    mutable std::vector<std::vector<long long>> m_Lengths;
+    mutable std::vector<std::vector<std::vector<long long>>> m_Counts;
+
+    // A derived sequence, with the positions of the prefix in the original sequence and the first appearance of each
+    // return word in the derived sequence
+    struct DerivedSequence{
+        std::vector<int> m_Sequence;
+        std::vector<int> m_Occurrences;
+        std::vector<int> m_FirstAppearance;
+    };
+
+    static std::vector<int> GetPrefixLengths(const std::vector<int>& Sequence);
+    static DerivedSequence Derive(const std::vector<int>& Sequence, const std::vector<int>& Z, int PrefixLength);
+    void AddLevel() const;
+};
+
+
+
+#endif
@@ -0,0 +1,131 @@
+/*******************************************************************************
+ *  CLASS NAME:	ThreadPool
+ *  AUTHOR:		Balazs Strenner
+ *				Copyright 2013 UW-Madison. All rights reserved.
+ *
+ *	DESCRIPTION: Runs numbered tasks on a few threads, and stops them now and then to let the calling thread look at
+                 their work.
+
+    SCHEDULING: The threads take the tasks in the order of their numbers, each thread the next one not taken yet when
+                it is done with the previous one. So a thread whose task ends early (e.g. a separatrix that reaches a
+                saddle connection) goes on with another one, and no thread is idle while there are tasks not taken.
+                The tasks are coarse (a separatrix, or a block of segments), so this is all the balancing needed, and
+                there are no queues for threads to steal from.
+
+    PAUSES:     Every Interval, the pool asks the tasks to stop. A task calls PauseIfRequested at the points where its
+                work is complete enough to be looked at. When every running task is stopped at such a point, OnPause is
+                called in the thread that called Run, and then the tasks go on. A task must not hold a lock that
+                another task waits for when it calls PauseIfRequested.
+
+    USE:        FoliationRP2 lengthens its separatrices in parallel (GenerateGoodShiftedSeparatrixSegments), and saves
+                the search during the pauses. It also searches for good curves in parallel (GenerateGoodCurves).
+ *
+ *
+ ******************************************************************************/
+
+#ifndef ArnouxYoccoz_ThreadPool_h
+#define ArnouxYoccoz_ThreadPool_h
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+
+
+
+class ThreadPool{
+public:
+    ThreadPool(int NumThreads) : m_NumThreads(NumThreads < 1 ? 1 : NumThreads), m_PauseRequested(false), m_NumRunning(0), m_NumPaused(0) {}
+
+    // Calls RunTask(i) for i = 0, ..., NumTasks - 1, and returns when all of them have returned. If Interval is not
+    // positive, the tasks are never paused.
+    template <typename Task, typename Callback>
+    void Run(int NumTasks, Task RunTask, std::chrono::steady_clock::duration Interval, Callback OnPause);
+    template <typename Task>
+    void Run(int NumTasks, Task RunTask){ Run(NumTasks, RunTask, std::chrono::steady_clock::duration::zero(), []{}); }
+    void PauseIfRequested();        // called by the tasks
+
+private:
+    int m_NumThreads;
+    std::atomic<bool> m_PauseRequested;
+    int m_NumRunning;       // the threads that are neither paused nor done
+    int m_NumPaused;
+    std::mutex m_Mutex;     // guards the counts above
+    std::condition_variable m_Changed;
+
+    ThreadPool(const ThreadPool&);
+    ThreadPool& operator=(const ThreadPool&);
+};
+
+
+
+
+template <typename Task, typename Callback>
+void ThreadPool::Run(int NumTasks, Task RunTask, std::chrono::steady_clock::duration Interval, Callback OnPause){
+    std::atomic<int> NextTask(0);
+    int NumThreads = NumTasks < m_NumThreads ? NumTasks : m_NumThreads;
+    m_NumRunning = NumThreads;
+    m_NumPaused = 0;
+    m_PauseRequested = false;
+
+    std::vector<std::thread> Threads;
+    for (int k = 0; k < NumThreads; k++) {
+        Threads.push_back(std::thread([&]{
+            for (int i = NextTask++; i < NumTasks; i = NextTask++) {
+                RunTask(i);
+            }
+            std::lock_guard<std::mutex> Lock(m_Mutex);
+            m_NumRunning--;
+            m_Changed.notify_all();
+        }));
+    }
+
+    {
+        std::unique_lock<std::mutex> Lock(m_Mutex);
+        while (m_NumRunning > 0) {
+            if (Interval <= std::chrono::steady_clock::duration::zero()) {
+                m_Changed.wait(Lock, [this]{ return m_NumRunning == 0; });
+                break;
+            }
+            if (m_Changed.wait_for(Lock, Interval, [this]{ return m_NumRunning == 0; })) {
+                break;
+            }
+            m_PauseRequested = true;
+            m_Changed.wait(Lock, [this]{ return m_NumRunning == 0; });
+            if (m_NumPaused > 0) {
+                OnPause();
+            }
+            m_NumRunning = m_NumPaused;
+            m_NumPaused = 0;
+            m_PauseRequested = false;
+            m_Changed.notify_all();
+        }
+    }
+
+    for (int k = 0; k < Threads.size(); k++) {
+        Threads[k].join();
+    }
+}
+
+
+
+
+inline void ThreadPool::PauseIfRequested(){
+    if (!m_PauseRequested) {
+        return;
+    }
+    std::unique_lock<std::mutex> Lock(m_Mutex);
+    if (!m_PauseRequested) {
+        return;
+    }
+    m_NumRunning--;
+    m_NumPaused++;
+    m_Changed.notify_all();
+    m_Changed.wait(Lock, [this]{ return !m_PauseRequested; });
+}
+
+
+
+#endif
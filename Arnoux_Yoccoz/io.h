@@ -10,6 +10,8 @@
 #define Arnoux_Yoccoz_io_h
 
 #include <iostream>
+#include <cstdlib>
+#include <thread>
 #include "FoliationRP2.h"
 
 using namespace std;
@@ -17,6 +19,12 @@ using namespace std;
 
 
 
+// Where the searches are kept between runs, see OrbitDatabase. Nothing is kept if the environment variable is not set.
+const OrbitDatabase Database = OrbitDatabase::FromEnvironment();
+
+
+
+
 
 
 char GetFirstCharOfLine(){
@@ -206,6 +214,83 @@ int GetDepth(){
 
 
 
+int GetNumReferenceCurves(){
+    int NumCurves = -1;
+    string Line;
+    while(NumCurves == -1){
+        try{
+            cout << "Number of reference curves (0 for all): ";
+            GetLine(Line);
+            istringstream ss(Line);
+            ss >> NumCurves;
+            if (ss.fail()) {
+                throw "The number of reference curves must be an integer.";
+            }
+            if (NumCurves < 0) {
+                throw "The number of reference curves can't be negative.";
+            }
+        }
+        catch (const char* Error){
+            cout << "*** Error: " << Error << "\n\n";
+            NumCurves = -1;
+        }
+    }
+    return NumCurves;
+}
+
+
+
+floating_point_type GetRelativeChange(){
+    floating_point_type Change = 0;
+    string Line;
+    while(Change == 0){
+        try{
+            cout << "Largest relative change: ";
+            GetLine(Line);
+            istringstream ss(Line);
+            ss >> Change;
+            if (ss.fail()) {
+                throw "The relative change must be a number.";
+            }
+            if (Change <= 0 || Change >= 1) {
+                throw "The relative change must be between 0 and 1.";
+            }
+        }
+        catch (const char* Error){
+            cout << "*** Error: " << Error << "\n\n";
+            Change = 0;
+        }
+    }
+    return Change;
+}
+
+
+
+long long GetLongDepth(){
+    long long Depth = 0;
+    string Line;
+    while(Depth == 0){
+        try{
+            cout << "Depth: ";
+            GetLine(Line);
+            istringstream ss(Line);
+            ss >> Depth;
+            if (ss.fail()) {
+                throw "The depth must be an integer.";
+            }
+            if (Depth < 2) {
+                throw "The depth must be at least 2.";
+            }
+        }
+        catch (const char* Error){
+            cout << "*** Error: " << Error << "\n\n";
+            Depth = 0;
+        }
+    }
+    return Depth;
+}
+
+
 
 
 
@@ -289,7 +374,7 @@ void PrintInfo(){
 
 
 
-FoliationRP2* GetFoliation(){
+FoliationRP2<>* GetFoliation(){
     while(true) {
         PrintTitle("ENTER A MEASURED FOLIATION");
         cout << "Choose a way:" << endl;
@@ -305,7 +390,7 @@ FoliationRP2* GetFoliation(){
         while (c != 'w' && c != 'l' && c != 'a' && c != 'r' && c != 'i' && c != 'q') {
             c = GetFirstCharOfLine();
         }
-        FoliationRP2* f = NULL;
+        FoliationRP2<>* f = NULL;
         switch (c) {
             case 'w':
             {
@@ -320,7 +405,7 @@ FoliationRP2* GetFoliation(){
                 while (f == NULL) {
                     try {
                         GetWeighedTreeInput(WeighedTreeInput);
-                        f = new FoliationRP2(WeighedTree(WeighedTreeInput));
+                        f = new FoliationRP2<>(WeighedTree(WeighedTreeInput));
                     }
                     catch (const char* Error){
                         cout << "*** Error: " << Error << "\n\n";
@@ -347,7 +432,7 @@ FoliationRP2* GetFoliation(){
                     try {
                         GetLengths(Lengths);
                         GetPair(Pair, static_cast<int>(Lengths.size()));
-                        f = new FoliationRP2(Lengths, Pair);
+                        f = new FoliationRP2<>(Lengths, Pair);
                     }
                     catch (const char* Error){
                         cout << "*** Error: " << Error << "\n\n";
@@ -361,16 +446,17 @@ FoliationRP2* GetFoliation(){
                 PrintTitle("ENTERING AN ARNOUX-YOCCOZ FOLIATION");
                 cout << "The Arnoux-Yoccoz foliation of which genus do you mean?\n\n";
                 
+                // The lengths are computed in the higher precision, and rounded for the foliation in the original one.
                 int genus = GetGenus();
-                AlmostPFMatrix AYMatrix = ArnouxYoccozMatrix(genus);
-                floating_point_type alpha = 1/AYMatrix.GetPFEigenvalue();
-                std::vector<floating_point_type> Lengths(genus);
-                for (int i = 1; i < genus; i++) {
-                    Lengths[i - 1] = (pow(alpha, i) + pow(alpha, i + 1))/4;
+                std::vector<FoliationRP2<>::precise_floating_point_type> PreciseLengths = ArnouxYoccozLengths<FoliationRP2<>::PrecisePrecision>(genus);
+                std::vector<floating_point_type> Lengths(PreciseLengths.size());
+                std::vector<int> Pair(PreciseLengths.size());
+                for (int i = 0; i < Lengths.size(); i++) {
+                    Lengths[i] = static_cast<floating_point_type>(PreciseLengths[i]);
+                    Pair[i] = i % 2 == 0 ? i + 1 : i - 1;
                 }
-                Lengths[genus - 1] = (alpha + pow(alpha, genus))/4;
                 
-                f = new FoliationRP2(WeighedTree(Lengths));
+                f = new FoliationRP2<>(Lengths, Pair, PreciseLengths);
                 return f;
             }
                 
@@ -379,7 +465,7 @@ FoliationRP2* GetFoliation(){
                 PrintTitle("RANDOM FOLIATION");
                 cout << "The genus of a foliation on RP^2 is the genus of the orintable surface obtained by the 4-fold branched cover over the singularities that orients both the surface and the foliation. The random foliation will be generated in the genus provided.\n\n";
 
-                f = new FoliationRP2(WeighedTree(GetGenus()));
+                f = new FoliationRP2<>(WeighedTree(GetGenus()));
                 return f;
             }
                 
@@ -417,6 +503,15 @@ void PrintOperationInfo(){
     cout << "A randomly chosen measured foliation is not going to be a stable/unstable foliation of a pseudo-anosov though. So when a good curve is found, a transition matrix with non-negative integer entries is computed which relates the original length vector to the new one, and if the matrix is Perron-Frobenius, the Perron-Frobenius eigenvector provides length parameters which are better candidates for a measured foliation belonging to a pseudo-anosov. Since the combinatorics of transverse one-sided simple closed curves changes when the measured foliation changes, another search for this new measured foliation has to be run.\n\n";
     
     
+    PrintTitle("SUBSTITUTIONS OF THE ITINERARIES");
+    cout << "The itinerary of a separatrix is the sequence of intervals it intersects. For the stable/unstable foliations of pseudo-anosovs the itineraries are fixed points of substitutions (after recoding), which can be detected from a long enough beginning of the itinerary. The expansion factor of the substitution is a power of the stretch factor. Once a substitution is found, the number of intersections of a separatrix segment of any depth with each interval is computed without following the separatrix.\n";
+    
+    
+    
+    PrintTitle("ITINERARIES OF NEARBY FOLIATIONS");
+    cout << "The lengths of each pair of intervals are changed in turn, by smaller and smaller relative amounts, and the separatrices of all these nearby foliations are followed together. For each change, the depth is listed up to which the itineraries of the separatrices agree with those of the current foliation. Up to that depth the good segments and their interval intersection counts are the same for the nearby foliation, so this shows how much the results depend on the exact lengths. If a divergence depth does not grow as the change gets smaller, a separatrix of the current foliation runs into a division point (or within rounding error of one) at that depth, and the smallest changes already break this saddle connection.\n";
+    
+    
     
     WaitForEnter();
 }
@@ -427,7 +522,24 @@ void PrintOperationInfo(){
 
 
 
-void PerformOperation(FoliationRP2* Foliation){
+void SaveSearch(FoliationRP2<>* Foliation){
+    if (Database.IsEnabled() && !Foliation->SaveState(Database)) {
+        cout << "*** Error: The search could not be saved in " << getenv(ORBIT_DATABASE_ENVIRONMENT_VARIABLE) << ".\n\n";
+    }
+}
+
+
+
+
+
+void PerformOperation(FoliationRP2<>* Foliation){
+    if (Foliation->LoadState(Database)) {
+        cout << "The search on this foliation is continued from where it was saved.\n";
+    }
+    if (Database.IsEnabled()) {
+        Foliation->SetStateDatabase(&Database);
+    }
+    Foliation->SetNumThreads(static_cast<int>(std::thread::hardware_concurrency()));     // 0 if it is not known, which means one thread
     bool Quit = false;
     while(!Quit) {
         PrintTitle("PERFORM AN OPERATION");
@@ -435,13 +547,15 @@ void PerformOperation(FoliationRP2* Foliation){
         cout << "- List good shifted separatrix segments (s)" << endl;
         cout << "- List good curves (c)" << endl;
         cout << "- Search for pseudo-anosovs (p)" << endl;
+        cout << "- Substitutions of the itineraries (u)" << endl;
+        cout << "- Itineraries of nearby foliations (n)" << endl;
         cout << "- More info (i)" << endl;
         cout << "- Choose another foliation (f)" << endl;
         cout << "- Quit (q)" << endl;
         cout << "(Press key and ENTER)" << endl;
         
         char c = 0;
-        while (c != 's' && c != 'c' && c != 'p' && c != 'i' && c != 'f' && c != 'q') {
+        while (c != 's' && c != 'c' && c != 'p' && c != 'u' && c != 'n' && c != 'i' && c != 'f' && c != 'q') {
             c = GetFirstCharOfLine();
         }
         switch (c) {
@@ -471,6 +585,7 @@ void PerformOperation(FoliationRP2* Foliation){
                         Foliation->PrintGoodShiftedSeparatrixSegmentsVerbose(GetDepth());
                         break;
                 }
+                SaveSearch(Foliation);
                 
                 WaitForEnter();
                 break;
@@ -479,12 +594,32 @@ void PerformOperation(FoliationRP2* Foliation){
                 PrintTitle("LISTING GOOD CURVES");
                 cout << "Enter the depth of search for good curves.\n\n";
                 Foliation->PrintGoodCurves(GetDepth());
+                SaveSearch(Foliation);
                 WaitForEnter();
                 break;
             case 'p':
                 PrintTitle("SEARCH FOR PSEUDO-ANOSOVS");
-                cout << "Enter the depth of search for pseudo-anosovs.\n\n";
-                Foliation->PrintPseudoAnosovs(GetDepth());
+                cout << "Enter the depth of search for pseudo-anosovs, and how many of the reference curves to cut along, the longest ones first.\n\n";
+                {
+                    int Depth = GetDepth();
+                    Foliation->PrintPseudoAnosovs(Depth, GetNumReferenceCurves());
+                }
+                SaveSearch(Foliation);
+                WaitForEnter();
+                break;
+            case 'u':
+                PrintTitle("SUBSTITUTIONS OF THE ITINERARIES");
+                cout << "Enter the depth of the separatrix segments whose interval intersection counts are computed from the substitutions. (Any depth takes about the same time.)\n\n";
+                Foliation->PrintItinerarySubstitutions(GetLongDepth());
+                WaitForEnter();
+                break;
+            case 'n':
+                PrintTitle("ITINERARIES OF NEARBY FOLIATIONS");
+                cout << "Enter the depth up to which the itineraries are compared, and the largest relative change of the lengths.\n\n";
+                {
+                    int Depth = GetDepth();
+                    Foliation->PrintNearbyItineraries(Depth, GetRelativeChange());
+                }
                 WaitForEnter();
                 break;
             case 'i':
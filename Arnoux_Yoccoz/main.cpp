@@ -27,7 +27,7 @@ int main (int argc, const char * argv[])
         2, (alpha + pow(alpha,3))/2};
 
     WeighedTree wt(list, 3);
-    FoliationRP2 fAY(wt);
+    FoliationRP2<> fAY(wt);
   //  std::cout << std::setprecision(30);
 
     std::cout << "aplha = " << 1/alpha << std::endl;
@@ -50,7 +50,7 @@ int main (int argc, const char * argv[])
     std::cout << "Time1:" << seconds << std::endl ;
 */
     Greetings();
-    FoliationRP2* Foliation;
+    FoliationRP2<>* Foliation;
     bool Exit = false;
     while(!Exit){
         try {